@@ -0,0 +1,113 @@
+/* Vector iteration benchmark: inlined accessors against raw pointer loop.
+ *
+ * Usage: containers-bench [elements [rounds]]
+ *
+ * Built with NDEBUG so that inlined accessors carry no checks.
+ */
+#include "containers.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#define DEFAULT_ELEMENTS        10000000
+#define DEFAULT_ROUNDS          10
+
+/* keeps the sums from being optimized out */
+static volatile uint64_t sink;
+
+static
+uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static
+void report(const char *name, uint64_t ns, size_t elements, size_t rounds) {
+    printf("%-20s: %6.3f ns per element\n",
+           name, (double)ns / (double)(elements * rounds));
+}
+
+static
+void bench_raw(vector_t *v, size_t rounds) {
+    const uint32_t *p, *end;
+    uint64_t start, sum = 0;
+    size_t r;
+
+    start = now_ns();
+
+    for (r = 0; r < rounds; ++r)
+        for (p = v->data.data, end = p + v->count; p != end; ++p)
+            sum += *p;
+
+    report("raw pointer", now_ns() - start, v->count, rounds);
+    sink = sum;
+}
+
+static
+void bench_get(vector_t *v, size_t rounds) {
+    uint64_t start, sum = 0;
+    size_t r, idx;
+
+    start = now_ns();
+
+    for (r = 0; r < rounds; ++r)
+        for (idx = 0; idx < v->count; ++idx)
+            sum += *(uint32_t *)vector_get(v, idx);
+
+    report("vector_get", now_ns() - start, v->count, rounds);
+    sink = sum;
+}
+
+static
+void bench_next(vector_t *v, size_t rounds) {
+    uint64_t start, sum = 0;
+    void *p, *end;
+    size_t r;
+
+    start = now_ns();
+
+    for (r = 0; r < rounds; ++r)
+        for (p = vector_begin(v), end = vector_end(v); p != end;
+             p = vector_next(v, p))
+            sum += *(uint32_t *)p;
+
+    report("vector_begin/next", now_ns() - start, v->count, rounds);
+    sink = sum;
+}
+
+int main(int argc, char **argv) {
+    vector_t v;
+    size_t elements = DEFAULT_ELEMENTS;
+    size_t rounds = DEFAULT_ROUNDS;
+    size_t idx;
+
+    if (argc > 1)
+        elements = strtoul(argv[1], NULL, 0);
+
+    if (argc > 2)
+        rounds = strtoul(argv[2], NULL, 0);
+
+    if (!elements)
+        elements = DEFAULT_ELEMENTS;
+
+    if (!rounds)
+        rounds = DEFAULT_ROUNDS;
+
+    vector_init(&v, sizeof(uint32_t), elements);
+
+    for (idx = 0; idx < elements; ++idx)
+        *(uint32_t *)vector_get(&v, idx) = (uint32_t)idx;
+
+    bench_raw(&v, rounds);
+    bench_get(&v, rounds);
+    bench_next(&v, rounds);
+
+    vector_deinit(&v);
+
+    return 0;
+}
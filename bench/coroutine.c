@@ -0,0 +1,247 @@
+/* Coroutine creation, context switch and memory footprint benchmark.
+ *
+ * Usage: coroutine-bench [iterations [idle coroutines]]
+ *
+ * Every coroutine stack takes two memory mappings (guard page and stack),
+ * so the number of idle coroutines is clamped to vm.max_map_count.
+ * Raise it to measure a million of them:
+ *   sysctl vm.max_map_count=2200000
+ */
+#include "coroutine.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+
+#define DEFAULT_ITERATIONS      1000000
+#define DEFAULT_IDLE            1000000
+#define IDLE_STACK_SIZE         (16 * 1024)
+/* mappings reserved for the rest of the process */
+#define MAP_COUNT_RESERVE       1024
+
+static const size_t stack_sizes[] = {
+    16 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024
+};
+
+#define STACK_SIZES_COUNT   (sizeof(stack_sizes) / sizeof(stack_sizes[0]))
+
+static
+uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static
+size_t resident_bytes(void) {
+    FILE *f = fopen("/proc/self/statm", "r");
+    unsigned long size = 0, resident = 0;
+
+    if (!f)
+        return 0;
+
+    if (2 != fscanf(f, "%lu %lu", &size, &resident))
+        resident = 0;
+
+    fclose(f);
+
+    return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+static
+size_t max_map_count(void) {
+    FILE *f = fopen("/proc/sys/vm/max_map_count", "r");
+    unsigned long count = 0;
+
+    if (!f)
+        return SIZE_MAX;
+
+    if (1 != fscanf(f, "%lu", &count))
+        count = SIZE_MAX;
+
+    fclose(f);
+
+    return (size_t)count;
+}
+
+static
+void ping_cb(coroutine_t *cr, void *ctx) {
+    while (true)
+        coroutine_yield(cr);
+}
+
+static
+void idle_cb(coroutine_t *cr, void *ctx) {
+    coroutine_yield(cr);
+}
+
+static
+void bench_init_deinit(size_t iterations, size_t stack_size,
+                       coroutine_stack_pool_t *pool, const char *what) {
+    coroutine_t cr;
+    uint64_t start, elapsed;
+    size_t i;
+
+    start = now_ns();
+
+    for (i = 0; i < iterations; ++i) {
+        coroutine_init_pooled(&cr, ping_cb, NULL, stack_size, pool);
+        coroutine_deinit(&cr);
+    }
+
+    elapsed = now_ns() - start;
+
+    printf("init/deinit %-8s %8zu KiB: %10.1f ns\n",
+           what, stack_size / 1024, (double)elapsed / iterations);
+}
+
+static
+void bench_pool(size_t iterations, size_t stack_size) {
+    coroutine_pool_t pool;
+    coroutine_t *cr;
+    uint64_t start, elapsed;
+    size_t i;
+
+    coroutine_pool_init(&pool, stack_size, 1);
+
+    start = now_ns();
+
+    for (i = 0; i < iterations; ++i) {
+        cr = coroutine_pool_get(&pool, idle_cb, NULL);
+        coroutine_pool_put(&pool, cr);
+    }
+
+    elapsed = now_ns() - start;
+
+    coroutine_pool_deinit(&pool);
+
+    printf("pool get/put         %8zu KiB: %10.1f ns\n",
+           stack_size / 1024, (double)elapsed / iterations);
+}
+
+static
+void bench_round_trip(size_t iterations, size_t stack_size) {
+    coroutine_t cr;
+    uint64_t start, elapsed;
+    size_t i;
+
+    coroutine_init(&cr, ping_cb, NULL, stack_size);
+
+    /* warm up, first switch runs the trampoline */
+    coroutine_continue(&cr);
+
+    start = now_ns();
+
+    for (i = 0; i < iterations; ++i)
+        coroutine_continue(&cr);
+
+    elapsed = now_ns() - start;
+
+    coroutine_deinit(&cr);
+
+    printf("continue/yield       %8zu KiB: %10.1f ns\n",
+           stack_size / 1024, (double)elapsed / iterations);
+}
+
+static
+void bench_idle(size_t count) {
+    coroutine_stack_pool_t pool;
+    coroutine_t *crs;
+    size_t limit = max_map_count();
+    size_t before, after;
+    uint64_t start, elapsed;
+    size_t i;
+
+    if (limit != SIZE_MAX && limit > MAP_COUNT_RESERVE &&
+        count > (limit - MAP_COUNT_RESERVE) / 2) {
+        count = (limit - MAP_COUNT_RESERVE) / 2;
+        printf("idle coroutines clamped to %zu by vm.max_map_count\n", count);
+    }
+
+    if (!count) {
+        printf("idle coroutines: no mappings left to measure with\n");
+        return;
+    }
+
+    /* don't keep stacks cached, measure the coroutines themselves */
+    coroutine_stack_pool_init(&pool, 0);
+
+    before = resident_bytes();
+    start = now_ns();
+
+    crs = malloc(count * sizeof(*crs));
+
+    if (!crs) {
+        printf("idle coroutines: out of memory\n");
+        return;
+    }
+
+    for (i = 0; i < count; ++i) {
+        coroutine_init_pooled(&crs[i], idle_cb, NULL, IDLE_STACK_SIZE, &pool);
+        coroutine_continue(&crs[i]);
+    }
+
+    elapsed = now_ns() - start;
+    after = resident_bytes();
+
+    printf("idle coroutines      %8zu    : %10.1f ns to start each\n",
+           count, (double)elapsed / count);
+    printf("idle coroutines      %8zu    : %10zu bytes resident each "
+           "(%zu in coroutine_t)\n",
+           count, (after > before ? after - before : 0) / count,
+           sizeof(coroutine_t));
+
+    for (i = 0; i < count; ++i) {
+        coroutine_continue(&crs[i]);
+        coroutine_deinit(&crs[i]);
+    }
+
+    free(crs);
+
+    coroutine_stack_pool_deinit(&pool);
+}
+
+int main(int argc, char **argv) {
+    coroutine_stack_pool_t uncached;
+    size_t iterations = DEFAULT_ITERATIONS;
+    size_t idle = DEFAULT_IDLE;
+    size_t i;
+
+    if (argc > 1)
+        iterations = strtoul(argv[1], NULL, 0);
+
+    if (argc > 2)
+        idle = strtoul(argv[2], NULL, 0);
+
+    if (!iterations)
+        iterations = DEFAULT_ITERATIONS;
+
+#ifdef COROUTINE_FAST_SWITCH
+    printf("context switch: hand-written\n");
+#else
+    printf("context switch: ucontext\n");
+#endif
+
+    coroutine_stack_pool_init(&uncached, 0);
+
+    for (i = 0; i < STACK_SIZES_COUNT; ++i) {
+        bench_init_deinit(iterations, stack_sizes[i], NULL, "pooled");
+        bench_init_deinit(iterations / 10 + 1, stack_sizes[i],
+                          &uncached, "mmap");
+        bench_pool(iterations, stack_sizes[i]);
+    }
+
+    coroutine_stack_pool_deinit(&uncached);
+
+    for (i = 0; i < STACK_SIZES_COUNT; ++i)
+        bench_round_trip(iterations, stack_sizes[i]);
+
+    if (idle)
+        bench_idle(idle);
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+#ifndef _ALLOCATOR_H_
+# define _ALLOCATOR_H_
+
+/** \file allocator.h
+ * Pluggable memory allocator used by containers.
+ * Every callback receives \c allocator_t::ctx.
+ * Sizes are passed to \c realloc and \c free so that allocators
+ * not keeping track of block sizes (arenas, pools) may be plugged in.
+ * Nil \c free means memory is released in bulk by allocator's owner,
+ * containers then skip walking their elements on purge.
+ */
+
+# include <stddef.h>
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+typedef struct allocator {
+    void *(*alloc)(void *ctx, size_t size);
+    void *(*realloc)(void *ctx, void *ptr, size_t old_size, size_t new_size);
+    void (*free)(void *ctx, void *ptr, size_t size);
+    void *ctx;
+} allocator_t;
+
+/** malloc/realloc/free based allocator */
+extern const allocator_t allocator_default;
+
+static inline
+void *allocator_alloc(const allocator_t *a, size_t size) {
+    return a->alloc(a->ctx, size);
+}
+
+static inline
+void *allocator_realloc(const allocator_t *a, void *ptr,
+                        size_t old_size, size_t new_size) {
+    return a->realloc(a->ctx, ptr, old_size, new_size);
+}
+
+static inline
+void allocator_free(const allocator_t *a, void *ptr, size_t size) {
+    if (a->free)
+        a->free(a->ctx, ptr, size);
+}
+
+# ifdef __cplusplus
+}
+# endif
+
+#endif /* _ALLOCATOR_H_ */
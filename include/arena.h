@@ -0,0 +1,92 @@
+#ifndef _ARENA_H_
+# define _ARENA_H_
+
+/** \file arena.h
+ * Arena (bump pointer) allocator.
+ * Memory is carved sequentially from a chain of blocks and is never
+ * released object by object. Instead the arena is rolled back to
+ * a checkpoint or reset as a whole, both in O(1).
+ * Blocks are kept for reuse until deinit.
+ * Not thread-safe.
+ */
+
+# include "allocator.h"
+
+# include <stdbool.h>
+# include <stddef.h>
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+# define ARENA_DEFAULT_BLOCK_SIZE   (64 * 1024)
+/* allocations are aligned on this boundary */
+# define ARENA_ALIGN                (2 * sizeof(void *))
+
+typedef struct arena_block arena_block_t;
+
+typedef struct arena {
+    size_t block_size;
+    /* chain of blocks, the ones after current are unused */
+    arena_block_t *first;
+    arena_block_t *current;
+    /* free part of current block */
+    char *ptr;
+    char *end;
+    /* the latest allocation, may be resized in place */
+    char *last;
+    /* allocator view of the arena, see \c arena_allocator */
+    allocator_t allocator;
+} arena_t;
+
+/** Position in arena to roll back to */
+typedef struct arena_checkpoint {
+    arena_block_t *block;
+    char *ptr;
+} arena_checkpoint_t;
+
+/**
+ * Initialize arena at \c a with blocks of \c block_size bytes,
+ * zero stands for \c ARENA_DEFAULT_BLOCK_SIZE.
+ * Larger allocations get dedicated blocks.
+ */
+void arena_init(arena_t *a, size_t block_size);
+/**
+ * Release every block
+ */
+void arena_deinit(arena_t *a);
+/**
+ * Allocate \c size bytes
+ */
+void *arena_alloc(arena_t *a, size_t size);
+/**
+ * Resize allocation at \c ptr of \c old_size bytes to \c new_size bytes.
+ * The latest allocation is resized in place if it fits current block.
+ * \return new address of the allocation
+ */
+void *arena_realloc(arena_t *a, void *ptr, size_t old_size, size_t new_size);
+/**
+ * Fetch current arena position
+ */
+arena_checkpoint_t arena_checkpoint(const arena_t *a);
+/**
+ * Release everything allocated after checkpoint \c cp was taken
+ */
+void arena_rollback(arena_t *a, arena_checkpoint_t cp);
+/**
+ * Release everything allocated from arena
+ */
+void arena_reset(arena_t *a);
+/**
+ * Fetch allocator to build containers on arena.
+ * Its \c free is nil so that containers skip walking their elements
+ * on purge, memory goes back with arena rollback or reset.
+ * Arena should not be moved while the allocator is in use.
+ */
+const allocator_t *arena_allocator(arena_t *a);
+
+# ifdef __cplusplus
+}
+# endif
+
+#endif /* _ARENA_H_ */
@@ -5,6 +5,9 @@
  * AVL tree library
  */
 
+# include "allocator.h"
+# include "slab.h"
+
 # include <stdbool.h>
 # include <stddef.h>
 # include <stdint.h>
@@ -40,6 +43,12 @@ struct avl_tree {
     bool inplace;
     size_t node_data_size;
     avl_tree_node_t *root;
+    /* nodes are allocated with */
+    const allocator_t *allocator;
+    /* nodes are allocated here instead of allocator if not nil */
+    slab_cache_t *slab;
+    /* slab is created by the tree and released on deinit */
+    bool slab_owned;
 };
 
 /**
@@ -48,6 +57,23 @@ struct avl_tree {
  * Node payload size is set with \c node_data_size.
  */
 void avl_tree_init(avl_tree_t *tree, bool inplace, size_t node_data_size);
+/**
+ * Initialize tree at \c tree with nodes allocated by \c allocator.
+ * Nil \c allocator stands for \c allocator_default.
+ */
+void avl_tree_init_allocator(avl_tree_t *tree, bool inplace,
+                             size_t node_data_size,
+                             const allocator_t *allocator);
+/**
+ * Initialize tree at \c tree with nodes allocated from \c slab.
+ * The slab may be shared between trees with the same \c inplace
+ * and \c node_data_size.
+ * If \c slab equals nil the tree creates its own one, every slab is then
+ * released at once on purge while the cache itself is kept until
+ * \c avl_tree_deinit.
+ */
+void avl_tree_init_slab(avl_tree_t *tree, bool inplace, size_t node_data_size,
+                        slab_cache_t *slab);
 /**
  * Fetch tree node with key \c k
  */
@@ -103,6 +129,10 @@ avl_tree_node_t *avl_tree_node_min(avl_tree_node_t *n);
  */
 avl_tree_node_t *avl_tree_node_max(avl_tree_node_t *n);
 void avl_tree_purge(avl_tree_t *tree);
+/**
+ * Purge the tree and release slab cache created by \c avl_tree_init_slab
+ */
+void avl_tree_deinit(avl_tree_t *tree);
 
 # ifdef __cplusplus
 }
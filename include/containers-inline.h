@@ -0,0 +1,31 @@
+#ifndef _CONTAINERS_INLINE_H_
+# define _CONTAINERS_INLINE_H_
+
+/** \file containers-inline.h
+ * Support for container accessors inlined from headers
+ */
+
+# include <assert.h>
+
+/** Checks in accessors inlined from headers.
+ * Compiled out along with \c assert when \c NDEBUG is defined,
+ * define \c CONTAINERS_UNCHECKED to drop only these ones.
+ */
+# ifdef CONTAINERS_UNCHECKED
+#  define CONTAINERS_CHECK(x)   ((void)0)
+# else
+#  define CONTAINERS_CHECK(x)   assert(x)
+# endif
+
+/** Accessors are defined in headers only when \c inline has C99 (or C++)
+ * meaning and doesn't emit an external definition in every unit.
+ * Otherwise (e.g. -std=gnu89 or -fgnu89-inline) they are just declared
+ * and the library's external definitions are called.
+ */
+# if defined(__GNUC_STDC_INLINE__) || defined(__cplusplus) || \
+     (!defined(__GNUC__) && defined(__STDC_VERSION__) && \
+      __STDC_VERSION__ >= 199901L)
+#  define CONTAINERS_INLINE_DEFINITIONS
+# endif
+
+#endif /* _CONTAINERS_INLINE_H_ */
@@ -3,9 +3,13 @@
 
 /** \file containers.h
  * Containers/collections library:
- * buffer, vector, array, list, queue, stack
+ * buffer, vector, deque, array, list, intrusive list, queue, stack
  */
 
+# include "allocator.h"
+# include "slab.h"
+# include "containers-inline.h"
+
 # include <stddef.h>
 # include <stdbool.h>
 
@@ -30,6 +34,12 @@ typedef struct buffer {
     size_t user_size;
     /** really allocated size */
     size_t real_size;
+    /** real size is never shrunk below this one */
+    size_t reserved;
+    /** data points to storage not owned by buffer */
+    bool inline_storage;
+    /** data is allocated with */
+    const allocator_t *allocator;
 } buffer_t;
 
 /** A vector with dynamic size
@@ -40,6 +50,40 @@ typedef struct vector {
     size_t count;
 } vector_t;
 
+/** A vector with room for \c n elements of \c type inline.
+ * Heap is used only when the vector outgrows inline storage.
+ * Operate on it with vector functions through \c v member after
+ * \c small_vector_init. The struct should not be moved or copied.
+ */
+# define SMALL_VECTOR(type, n)                                              \
+    struct {                                                                \
+        vector_t v;                                                         \
+        type storage[n];                                                    \
+    }
+
+/**
+ * Initialize small vector at \c sv, see \c SMALL_VECTOR
+ */
+# define small_vector_init(sv)                                              \
+    vector_init_inline(&(sv)->v, sizeof((sv)->storage[0]), (sv)->storage,   \
+                       sizeof((sv)->storage) / sizeof((sv)->storage[0]))
+
+/** Vector element predicate, see \c vector_remove_if
+ */
+typedef bool (*vector_predicate_t)(const void *el, void *ctx);
+
+/** A double-ended queue in circular buffer.
+ * Capacity is a power of two, elements wrap around the buffer end.
+ */
+typedef struct deque {
+    buffer_t data;
+    size_t element_size;
+    /* index of the first element in buffer */
+    size_t head;
+    size_t count;
+    size_t capacity;
+} deque_t;
+
 /** A doubly linked list
  */
 typedef struct list list_t;
@@ -56,8 +100,37 @@ struct list {
     size_t count;
     bool inplace;
     size_t element_size;
+    /* elements are allocated with */
+    const allocator_t *allocator;
+    /* elements are allocated here instead of allocator if not nil */
+    slab_cache_t *slab;
+    /* slab is created by the list and released on deinit */
+    bool slab_owned;
 };
 
+/** Link of intrusive doubly linked list.
+ * Embedded into user's object, see \c ilist_entry
+ */
+typedef struct ilist_link {
+    struct ilist_link *prev;
+    struct ilist_link *next;
+} ilist_link_t;
+
+/** Intrusive doubly linked list.
+ * Circular around \c head sentinel, so the list should not be copied.
+ * No memory is allocated by list operations.
+ */
+typedef struct ilist {
+    ilist_link_t head;
+    size_t count;
+} ilist_t;
+
+/**
+ * Fetch pointer to object of \c type which embeds \c link as \c member
+ */
+# define ilist_entry(link, type, member)                                     \
+    ((type *)((char *)(link) - offsetof(type, member)))
+
 /**** buffer operations ****/
 /**
  * Initialize buffer \c b with initial size \c size and policy \c pol
@@ -65,10 +138,34 @@ struct list {
 void buffer_init(buffer_t *b,
                  size_t size,
                  enum buffer_policy pol);
+/**
+ * Initialize buffer \c b with memory allocated by \c allocator.
+ * Nil \c allocator stands for \c allocator_default.
+ */
+void buffer_init_allocator(buffer_t *b,
+                           size_t size,
+                           enum buffer_policy pol,
+                           const allocator_t *allocator);
+/**
+ * Initialize empty buffer \c b on top of \c storage of \c storage_size
+ * bytes owned by caller.
+ * Data is moved to heap once buffer outgrows the storage.
+ */
+void buffer_init_inline(buffer_t *b, void *storage, size_t storage_size,
+                        enum buffer_policy pol);
 /**
  * Change buffer \c b size to \c newsize according to buffer's policy
  */
 bool buffer_realloc(buffer_t *b, size_t newsize);
+/**
+ * Make buffer \c b hold at least \c size bytes without changing user size.
+ * Buffer is not shrunk below \c size by any policy afterwards.
+ */
+bool buffer_reserve(buffer_t *b, size_t size);
+/**
+ * Drop reservation and release memory beyond user size
+ */
+bool buffer_shrink_to_fit(buffer_t *b);
 /**
  * Deallocate allocated memory
  */
@@ -80,10 +177,41 @@ void buffer_deinit(buffer_t *b);
  * and each element of size \c size
  */
 void vector_init(vector_t *v, size_t size, size_t count);
+/**
+ * Initialize vector at \c v with storage allocated by \c allocator.
+ * Nil \c allocator stands for \c allocator_default.
+ */
+void vector_init_allocator(vector_t *v, size_t size, size_t count,
+                           const allocator_t *allocator);
+/**
+ * Initialize empty vector at \c v on top of \c storage with room for
+ * \c capacity elements of size \c size.
+ * Elements are moved to heap once the vector outgrows the storage.
+ */
+void vector_init_inline(vector_t *v, size_t size,
+                        void *storage, size_t capacity);
 /**
  * Deallocate vector
  */
 void vector_deinit(vector_t *v);
+/**
+ * Fetch number of elements vector \c v may hold without reallocation
+ */
+size_t vector_capacity(const vector_t *v);
+/**
+ * Make room for at least \c count elements in vector \c v.
+ * The capacity is kept until \c vector_shrink_to_fit, no matter how many
+ * elements are removed.
+ */
+void vector_reserve(vector_t *v, size_t count);
+/**
+ * Release memory not occupied by elements and drop reservation
+ */
+void vector_shrink_to_fit(vector_t *v);
+/**
+ * Remove every element keeping current capacity reserved
+ */
+void vector_clear(vector_t *v);
 /**
  * Remove single element from vector
  */
@@ -92,6 +220,17 @@ void vector_remove(vector_t *v, size_t idx);
  * Remove consecutive elements from vector
  */
 void vector_remove_range(vector_t *v, size_t from, size_t count);
+/**
+ * Remove single element from vector moving the last element in its place.
+ * Order of elements is not kept, the buffer is not shrunk.
+ */
+void vector_swap_remove(vector_t *v, size_t idx);
+/**
+ * Remove the last element of vector \c v copying it to \c el if not nil.
+ * The buffer is not shrunk.
+ * \return \c false if vector is empty
+ */
+bool vector_pop_back(vector_t *v, void *el);
 /**
  * Insert element to vector \c v at index \c idx
  * \return pointer to inserted element
@@ -107,29 +246,169 @@ void *vector_append(vector_t *v);
  * \return pointer to inserted element
  */
 void *vector_prepend(vector_t *v);
+/**
+ * Append \c count elements copied from \c src to vector \c v.
+ * Elements are left uninitialized if \c src equals nil.
+ * \c src should not point into the vector.
+ * \return pointer to the first appended element
+ */
+void *vector_append_n(vector_t *v, const void *src, size_t count);
+/**
+ * Insert \c count elements copied from \c src to vector \c v
+ * at index \c idx.
+ * Elements are left uninitialized if \c src equals nil.
+ * \c src should not point into the vector.
+ * \return pointer to the first inserted element
+ */
+void *vector_insert_n(vector_t *v, size_t idx, const void *src, size_t count);
+/**
+ * Replace contents of vector \c v with \c count elements copied
+ * from \c src.
+ * Elements are left uninitialized if \c src equals nil.
+ * \c src should not point into the vector.
+ */
+void vector_assign(vector_t *v, const void *src, size_t count);
+/**
+ * Remove every element of vector \c v which \c pred returns \c true for.
+ * Order of the rest elements is kept.
+ * \return number of elements removed
+ */
+size_t vector_remove_if(vector_t *v, vector_predicate_t pred, void *ctx);
 /**
  * Fetch the first vector element address
  * \return pointer to the first element in vector
  */
+# ifdef CONTAINERS_INLINE_DEFINITIONS
+inline
+void *vector_begin(vector_t *v) {
+    CONTAINERS_CHECK(v);
+    return v->data.data;
+}
+# else
 void *vector_begin(vector_t *v);
+# endif
 /**
  * Fetch address of the element after the last one in vector
  * \return pointer to the after-the-last-one element of the vector
  */
+# ifdef CONTAINERS_INLINE_DEFINITIONS
+inline
+void *vector_end(vector_t *v) {
+    CONTAINERS_CHECK(v);
+    return (char *)v->data.data + v->count * v->element_size;
+}
+# else
 void *vector_end(vector_t *v);
+# endif
 /**
  * Fetch vector element at index \c idx
  * \return pointer to the element
  */
+# ifdef CONTAINERS_INLINE_DEFINITIONS
+inline
+void *vector_get(vector_t *v, size_t idx) {
+    CONTAINERS_CHECK(v);
+    CONTAINERS_CHECK(v->count > idx);
+
+    return (char *)v->data.data + idx * v->element_size;
+}
+# else
 void *vector_get(vector_t *v, size_t idx);
+# endif
 /**
  * Get next element pointer
  */
+# ifdef CONTAINERS_INLINE_DEFINITIONS
+inline
+void *vector_next(vector_t *v, void *d) {
+    CONTAINERS_CHECK(v);
+    CONTAINERS_CHECK(!((char *)d < (char *)v->data.data));
+    CONTAINERS_CHECK((char *)d < (char *)vector_end(v));
+    CONTAINERS_CHECK(((char *)d - (char *)v->data.data) %
+                     v->element_size == 0);
+
+    return (char *)d + v->element_size;
+}
+# else
 void *vector_next(vector_t *v, void *d);
+# endif
 /**
  * Get previous element pointer
  */
+# ifdef CONTAINERS_INLINE_DEFINITIONS
+inline
+void *vector_prev(vector_t *v, void *d) {
+    CONTAINERS_CHECK(v);
+    CONTAINERS_CHECK(!((char *)d < (char *)v->data.data));
+    CONTAINERS_CHECK((char *)d < (char *)vector_end(v));
+    CONTAINERS_CHECK(((char *)d - (char *)v->data.data) %
+                     v->element_size == 0);
+
+    return d == v->data.data ? d : (char *)d - v->element_size;
+}
+# else
 void *vector_prev(vector_t *v, void *d);
+# endif
+
+/**** deque operations ****/
+/**
+ * Initialize deque at \c d with elements of size \c size and room
+ * for at least \c capacity elements
+ */
+void deque_init(deque_t *d, size_t size, size_t capacity);
+/**
+ * Initialize deque at \c d with storage allocated by \c allocator.
+ * Nil \c allocator stands for \c allocator_default.
+ */
+void deque_init_allocator(deque_t *d, size_t size, size_t capacity,
+                          const allocator_t *allocator);
+/**
+ * Deallocate deque
+ */
+void deque_deinit(deque_t *d);
+/**
+ * Return number of elements in deque
+ */
+size_t deque_size(const deque_t *d);
+/**
+ * Remove every element keeping the memory
+ */
+void deque_clear(deque_t *d);
+/**
+ * Add element to deque \c d at the end
+ * \return pointer to added element
+ */
+void *deque_push_back(deque_t *d);
+/**
+ * Add element to deque \c d at the beginning
+ * \return pointer to added element
+ */
+void *deque_push_front(deque_t *d);
+/**
+ * Remove the last element of deque \c d copying it to \c el if not nil
+ * \return \c false if deque is empty
+ */
+bool deque_pop_back(deque_t *d, void *el);
+/**
+ * Remove the first element of deque \c d copying it to \c el if not nil
+ * \return \c false if deque is empty
+ */
+bool deque_pop_front(deque_t *d, void *el);
+/**
+ * Fetch deque element at index \c idx counting from the front
+ * \return pointer to the element
+ */
+void *deque_get(deque_t *d, size_t idx);
+/**
+ * Fetch the first deque element
+ * \return pointer to the element or nil if deque is empty
+ */
+void *deque_front(deque_t *d);
+/**
+ * Fetch the last deque element
+ * \return pointer to the element or nil if deque is empty
+ */
+void *deque_back(deque_t *d);
 
 /**** list operations ****/
 /**
@@ -139,10 +418,32 @@ void *vector_prev(vector_t *v, void *d);
  * List element payload size passed in \c size
  */
 void list_init(list_t *l, bool inplace, size_t size);
+/**
+ * Initialize list at \c l with elements allocated by \c allocator.
+ * Nil \c allocator stands for \c allocator_default.
+ */
+void list_init_allocator(list_t *l, bool inplace, size_t size,
+                         const allocator_t *allocator);
+/**
+ * Initialize list at \c l with elements allocated from \c slab.
+ * The slab may be shared between lists with the same \c inplace and \c size.
+ * If \c slab equals nil the list creates its own one, every slab is then
+ * released at once on purge while the cache itself is kept until
+ * \c list_deinit. Own slab memory comes from list's allocator.
+ */
+void list_init_slab(list_t *l, bool inplace, size_t size, slab_cache_t *slab);
 /**
  * Return number of elements in list
  */
+# ifdef CONTAINERS_INLINE_DEFINITIONS
+inline
+size_t list_size(const list_t *l) {
+    CONTAINERS_CHECK(l);
+    return l->count;
+}
+# else
 size_t list_size(const list_t *l);
+# endif
 /**
  * Add element to the list at the beginning
  */
@@ -169,26 +470,126 @@ list_element_t *list_remove_and_advance(list_t *l, list_element_t *el);
  * Deallocate the list
  */
 void list_purge(list_t *l);
+/**
+ * Deallocate the list and release slab cache created by \c list_init_slab
+ */
+void list_deinit(list_t *l);
 /**
  * Return the first list element pointer.
  * \return pointer or \c NULL if there are no elements in the list yet
  */
+# ifdef CONTAINERS_INLINE_DEFINITIONS
+inline
+list_element_t *list_begin(list_t *l) {
+    CONTAINERS_CHECK(l);
+    return l->front;
+}
+# else
 list_element_t *list_begin(list_t *l);
+# endif
 /**
  * Return the last list element pointer.
  * \return pointer or \c NULL if there are no elements in the list yet
  */
+# ifdef CONTAINERS_INLINE_DEFINITIONS
+inline
+list_element_t *list_end(list_t *l) {
+    CONTAINERS_CHECK(l);
+    return l->back;
+}
+# else
 list_element_t *list_end(list_t *l);
+# endif
 /**
  * Return the next list element pointer.
  * \return pointer or \c NULL if there are no more elements
  */
+# ifdef CONTAINERS_INLINE_DEFINITIONS
+inline
+list_element_t *list_next(list_t *l, list_element_t *el) {
+    CONTAINERS_CHECK(l);
+    CONTAINERS_CHECK(!el || el->host == l);
+
+    return !el ? l->front : el->next;
+}
+# else
 list_element_t *list_next(list_t *l, list_element_t *el);
+# endif
 /**
  * Return the previous list element pointer.
  * \return pointer or \c NULL if there are no more elements
  */
+# ifdef CONTAINERS_INLINE_DEFINITIONS
+inline
+list_element_t *list_prev(list_t *l, list_element_t *el) {
+    CONTAINERS_CHECK(l);
+    CONTAINERS_CHECK(!el || el->host == l);
+
+    return !el ? l->back : el->prev;
+}
+# else
 list_element_t *list_prev(list_t *l, list_element_t *el);
+# endif
+
+/**** intrusive list operations ****/
+void ilist_init(ilist_t *l);
+size_t ilist_size(const ilist_t *l);
+bool ilist_empty(const ilist_t *l);
+/**
+ * Mark \c link as not linked into any list
+ */
+void ilist_link_init(ilist_link_t *link);
+/**
+ * \return \c true if \c link is in a list.
+ * Valid for links initialized with \c ilist_link_init or removed from a list.
+ */
+bool ilist_linked(const ilist_link_t *link);
+void ilist_push_front(ilist_t *l, ilist_link_t *link);
+void ilist_push_back(ilist_t *l, ilist_link_t *link);
+/**
+ * Insert \c link after \c pos.
+ * The link is pushed to front when \c pos equals nil
+ */
+void ilist_insert_after(ilist_t *l, ilist_link_t *pos, ilist_link_t *link);
+/**
+ * Insert \c link right before \c pos.
+ * The link is pushed to back when \c pos equals nil
+ */
+void ilist_insert_before(ilist_t *l, ilist_link_t *pos, ilist_link_t *link);
+/**
+ * Unlink \c link from list \c l
+ */
+void ilist_remove(ilist_t *l, ilist_link_t *link);
+/**
+ * Unlink the first link
+ * \return link or \c NULL if list is empty
+ */
+ilist_link_t *ilist_pop_front(ilist_t *l);
+/**
+ * Unlink the last link
+ * \return link or \c NULL if list is empty
+ */
+ilist_link_t *ilist_pop_back(ilist_t *l);
+/**
+ * Move every link of \c from to the end of \c to in constant time
+ */
+void ilist_splice(ilist_t *to, ilist_t *from);
+/**
+ * \return the first link or \c NULL if list is empty
+ */
+ilist_link_t *ilist_front(ilist_t *l);
+/**
+ * \return the last link or \c NULL if list is empty
+ */
+ilist_link_t *ilist_back(ilist_t *l);
+/**
+ * \return the next link or \c NULL if there are no more links
+ */
+ilist_link_t *ilist_next(ilist_t *l, ilist_link_t *link);
+/**
+ * \return the previous link or \c NULL if there are no more links
+ */
+ilist_link_t *ilist_prev(ilist_t *l, ilist_link_t *link);
 
 # ifdef __cplusplus
 }
@@ -0,0 +1,114 @@
+#ifndef _COROUTINE_CHANNEL_H_
+# define _COROUTINE_CHANNEL_H_
+
+/** \file coroutine-channel.h
+ * Channels between coroutines run by \c coroutine_scheduler_t.
+ * Elements are copied by value into a ring buffer.
+ * Sender blocked on a full channel and receiver blocked on an empty one
+ * park their coroutine. Peer hands element over directly to a parked
+ * receiver's destination or takes it directly from a parked sender.
+ */
+
+# include "coroutine.h"
+# include "coroutine-scheduler.h"
+# include "containers.h"
+
+# include <stdbool.h>
+# include <stddef.h>
+# include <pthread.h>
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+typedef struct coroutine_channel {
+    pthread_mutex_t mtx;
+
+    /* ring buffer of elements */
+    buffer_t ring;
+    size_t element_size;
+    /* elements the ring can hold */
+    size_t capacity;
+    /* index of the oldest element */
+    size_t head;
+    size_t count;
+
+    bool bounded;
+    bool closed;
+
+    coroutine_wait_queue_t senders;
+    coroutine_wait_queue_t receivers;
+} coroutine_channel_t;
+
+/**
+ * Initialize bounded channel of up to \c capacity elements of
+ * size \c element_size. Zero \c capacity makes the channel unbuffered:
+ * each send waits for a receiver.
+ */
+void coroutine_channel_init(coroutine_channel_t *ch,
+                            size_t element_size, size_t capacity);
+/**
+ * Initialize unbounded channel. Send never parks.
+ */
+void coroutine_channel_init_unbounded(coroutine_channel_t *ch,
+                                      size_t element_size);
+void coroutine_channel_deinit(coroutine_channel_t *ch);
+/**
+ * Close the channel.
+ * Parked senders fail, parked receivers fail once the channel is drained.
+ */
+void coroutine_channel_close(coroutine_channel_t *ch);
+/**
+ * Copy element at \c el into the channel, parking \c cr while it's full.
+ * \return \c false if the channel is closed
+ */
+bool coroutine_channel_send(coroutine_channel_t *ch, coroutine_t *cr,
+                            const void *el);
+/**
+ * Copy the oldest element to \c el, parking \c cr while channel is empty.
+ * \return \c false if the channel is closed and drained
+ */
+bool coroutine_channel_recv(coroutine_channel_t *ch, coroutine_t *cr,
+                            void *el);
+/**
+ * Send without parking, usable outside of coroutines
+ * \return \c false if the channel is full or closed
+ */
+bool coroutine_channel_try_send(coroutine_channel_t *ch, const void *el);
+/**
+ * Receive without parking, usable outside of coroutines
+ * \return \c false if the channel is empty
+ */
+bool coroutine_channel_try_recv(coroutine_channel_t *ch, void *el);
+/**
+ * Return number of buffered elements
+ */
+size_t coroutine_channel_size(coroutine_channel_t *ch);
+
+/**
+ * Declare static inline wrappers named \c name_send, \c name_recv,
+ * \c name_try_send and \c name_try_recv over channel of \c T elements
+ */
+# define DECLARE_COROUTINE_CHANNEL(name, T)                                 \
+static inline                                                               \
+bool name ## _send(coroutine_channel_t *ch, coroutine_t *cr, T v) {         \
+    return coroutine_channel_send(ch, cr, &v);                              \
+}                                                                           \
+static inline                                                               \
+bool name ## _recv(coroutine_channel_t *ch, coroutine_t *cr, T *v) {        \
+    return coroutine_channel_recv(ch, cr, v);                               \
+}                                                                           \
+static inline                                                               \
+bool name ## _try_send(coroutine_channel_t *ch, T v) {                      \
+    return coroutine_channel_try_send(ch, &v);                              \
+}                                                                           \
+static inline                                                               \
+bool name ## _try_recv(coroutine_channel_t *ch, T *v) {                     \
+    return coroutine_channel_try_recv(ch, v);                               \
+}
+
+# ifdef __cplusplus
+}
+# endif
+
+#endif /* _COROUTINE_CHANNEL_H_ */
@@ -0,0 +1,244 @@
+#ifndef _COROUTINE_SCHEDULER_H_
+# define _COROUTINE_SCHEDULER_H_
+
+/** \file coroutine-scheduler.h
+ * M:N coroutine scheduler.
+ * Each worker thread owns a Chase-Lev deque of runnable coroutines.
+ * Idle workers steal from the others' deques.
+ * Coroutines readied outside of worker threads and yielded ones
+ * go to the shared injection queue.
+ * Timed parks are kept in scheduler's min-heap of deadlines which
+ * workers check between coroutines and sleep on when idle.
+ */
+
+# include "coroutine.h"
+# include "containers.h"
+
+# include <stdbool.h>
+# include <stddef.h>
+# include <stdint.h>
+# include <stdatomic.h>
+# include <pthread.h>
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+struct coroutine_scheduler;
+typedef struct coroutine_scheduler coroutine_scheduler_t;
+
+struct coroutine_worker;
+typedef struct coroutine_worker coroutine_worker_t;
+
+struct coroutine_deque_array;
+typedef struct coroutine_deque_array coroutine_deque_array_t;
+
+struct coroutine_waiter;
+typedef struct coroutine_waiter coroutine_waiter_t;
+
+struct coroutine_deque_array {
+    /* power of two */
+    size_t size;
+    /* retired by growth, freed with the deque */
+    coroutine_deque_array_t *retired;
+    _Atomic(coroutine_t *) buf[];
+};
+
+/** Chase-Lev work-stealing deque.
+ * Owner pushes and takes at the bottom, thieves steal from the top.
+ */
+typedef struct coroutine_deque {
+    _Atomic(int64_t) top;
+    _Atomic(int64_t) bottom;
+    _Atomic(coroutine_deque_array_t *) array;
+} coroutine_deque_t;
+
+struct coroutine_worker {
+    coroutine_scheduler_t *sched;
+    size_t idx;
+    pthread_t thread;
+
+    coroutine_deque_t deque;
+
+    /* coroutine being run by the worker */
+    coroutine_t *current;
+
+    unsigned int seed;
+    size_t ticks;
+};
+
+/** Armed timer, each coroutine has at most one */
+typedef struct coroutine_timer {
+    /* coroutine_clock() based */
+    uint64_t deadline;
+    coroutine_t *cr;
+} coroutine_timer_t;
+
+# define COROUTINE_TIMER_NONE   UINT64_MAX
+
+struct coroutine_scheduler {
+    coroutine_worker_t *workers;
+    size_t workers_count;
+
+    /* coroutine_t linked by sched_link */
+    ilist_t injected;
+    atomic_size_t injected_count;
+
+    /* coroutines spawned and not returned yet */
+    atomic_size_t live;
+    atomic_size_t idle;
+    atomic_bool stopping;
+
+    /* coroutine_timer_t, min-heap by deadline, protected by mtx */
+    vector_t timers;
+    /* the earliest deadline or COROUTINE_TIMER_NONE */
+    _Atomic(uint64_t) next_timer;
+
+    pthread_mutex_t mtx;
+    /* idle workers wait here */
+    pthread_cond_t work_cond;
+    /* coroutine_scheduler_wait waits here */
+    pthread_cond_t done_cond;
+};
+
+/** Coroutine waiting for an event.
+ * Lives on the waiting coroutine's stack and is linked into
+ * a wait queue of a synchronization object.
+ */
+struct coroutine_waiter {
+    coroutine_t *cr;
+
+    coroutine_waiter_t *prev;
+    coroutine_waiter_t *next;
+
+    /* set by waker, waiter leaves once it's set */
+    atomic_bool woken;
+    /* outcome reported by waker */
+    int result;
+    /* payload exchanged between waker and waiter */
+    void *data;
+    /* linked into a queue, protected by the queue's owner */
+    bool queued;
+};
+
+/** Intrusive FIFO of waiters.
+ * Not thread-safe, protected by the owning object.
+ */
+typedef struct coroutine_wait_queue {
+    coroutine_waiter_t *front;
+    coroutine_waiter_t *back;
+    size_t count;
+} coroutine_wait_queue_t;
+
+/**
+ * Initialize scheduler and start \c workers_count worker threads.
+ * Zero \c workers_count stands for number of online CPUs.
+ */
+void coroutine_scheduler_init(coroutine_scheduler_t *s, size_t workers_count);
+/**
+ * Stop and join worker threads.
+ * Coroutines that did not return by now are leaked,
+ * use \c coroutine_scheduler_wait beforehand.
+ */
+void coroutine_scheduler_deinit(coroutine_scheduler_t *s);
+/**
+ * Block calling thread until every spawned coroutine returns
+ */
+void coroutine_scheduler_wait(coroutine_scheduler_t *s);
+/**
+ * Create coroutine and make it runnable.
+ * Coroutine is destroyed by scheduler once it returns.
+ * \return coroutine pointer valid until the coroutine returns
+ */
+coroutine_t *coroutine_spawn(coroutine_scheduler_t *s,
+                             coroutine_cb_t cb, void *ctx,
+                             size_t stack_size);
+/**
+ * Put coroutine \c cr to the end of run queue and switch to scheduler.
+ * Should be called from within \c cr.
+ */
+void coroutine_scheduler_yield(coroutine_t *cr);
+/**
+ * Suspend coroutine \c cr until \c coroutine_unpark is called for it.
+ * Returns at once if \c cr was unparked since it was last parked.
+ * Spurious returns are possible, callers should recheck their condition.
+ * Should be called from within \c cr.
+ */
+void coroutine_park(coroutine_t *cr);
+/**
+ * Make parked coroutine \c cr runnable.
+ * If \c cr is not parked the next \c coroutine_park call won't suspend it.
+ * May be called from any thread.
+ */
+void coroutine_unpark(coroutine_t *cr);
+/**
+ * Park coroutine \c cr until \c coroutine_unpark is called for it
+ * or \c deadline passes.
+ * Should be called from within \c cr.
+ * \return \c false if deadline passed,
+ *         \c true if unparked (or spuriously returned) before that
+ */
+bool coroutine_park_until(coroutine_t *cr, uint64_t deadline);
+/**
+ * Suspend coroutine \c cr for at least \c duration nanoseconds.
+ * Worker thread goes on running other coroutines.
+ * Should be called from within \c cr.
+ */
+void coroutine_sleep(coroutine_t *cr, uint64_t duration);
+/**
+ * Fetch monotonic time in nanoseconds, base of deadlines
+ */
+uint64_t coroutine_clock(void);
+/**
+ * Take reference to spawned coroutine \c cr so that it outlives its return
+ */
+void coroutine_retain(coroutine_t *cr);
+/**
+ * Release reference to spawned coroutine \c cr,
+ * the last one destroys it
+ */
+void coroutine_release(coroutine_t *cr);
+/**
+ * Fetch worker run by the calling thread
+ * \return worker pointer or \c NULL if called outside of worker threads
+ */
+coroutine_worker_t *coroutine_worker_current(void);
+
+/**** waiters ****/
+void coroutine_waiter_init(coroutine_waiter_t *w, coroutine_t *cr, void *data);
+/**
+ * Park waiter's coroutine until the waiter is woken
+ * \return result passed by waker
+ */
+int coroutine_waiter_wait(coroutine_waiter_t *w);
+/**
+ * Park waiter's coroutine until the waiter is woken or \c deadline passes.
+ * Timed out waiter may still be linked into its queue,
+ * the owner should unlink it if \c queued or wait for the waker otherwise.
+ * \return \c true if waiter was woken, result is in \c w->result then
+ */
+bool coroutine_waiter_wait_until(coroutine_waiter_t *w, uint64_t deadline);
+/**
+ * Wake waiter \c w with \c result.
+ * Waiter should be unlinked from its queue already.
+ * Waiter's memory is not touched afterwards.
+ */
+void coroutine_waiter_wake(coroutine_waiter_t *w, int result);
+
+void coroutine_wait_queue_init(coroutine_wait_queue_t *q);
+bool coroutine_wait_queue_empty(const coroutine_wait_queue_t *q);
+void coroutine_wait_queue_push(coroutine_wait_queue_t *q,
+                               coroutine_waiter_t *w);
+/**
+ * Unlink the first waiter
+ * \return waiter or \c NULL if queue is empty
+ */
+coroutine_waiter_t *coroutine_wait_queue_pop(coroutine_wait_queue_t *q);
+void coroutine_wait_queue_remove(coroutine_wait_queue_t *q,
+                                 coroutine_waiter_t *w);
+
+# ifdef __cplusplus
+}
+# endif
+
+#endif /* _COROUTINE_SCHEDULER_H_ */
@@ -0,0 +1,141 @@
+#ifndef _COROUTINE_SYNC_H_
+# define _COROUTINE_SYNC_H_
+
+/** \file coroutine-sync.h
+ * Synchronization primitives for coroutines run by \c coroutine_scheduler_t:
+ * mutex, counting semaphore, condition variable and wait group.
+ * Contention parks only the calling coroutine, worker thread goes on
+ * running others. Ownership or permit is handed over directly to
+ * the longest waiting coroutine.
+ * Timed variants take timeout in nanoseconds and are served by
+ * scheduler's timer heap.
+ */
+
+# include "coroutine.h"
+# include "coroutine-scheduler.h"
+
+# include <stdbool.h>
+# include <stddef.h>
+# include <stdint.h>
+# include <pthread.h>
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+typedef struct coroutine_mutex {
+    /* protects the fields below */
+    pthread_mutex_t guard;
+    bool locked;
+    coroutine_wait_queue_t waiters;
+} coroutine_mutex_t;
+
+typedef struct coroutine_sem {
+    pthread_mutex_t guard;
+    size_t count;
+    coroutine_wait_queue_t waiters;
+} coroutine_sem_t;
+
+typedef struct coroutine_cond {
+    pthread_mutex_t guard;
+    coroutine_wait_queue_t waiters;
+} coroutine_cond_t;
+
+typedef struct coroutine_wait_group {
+    pthread_mutex_t guard;
+    size_t count;
+    coroutine_wait_queue_t waiters;
+} coroutine_wait_group_t;
+
+/**** mutex ****/
+void coroutine_mutex_init(coroutine_mutex_t *m);
+void coroutine_mutex_deinit(coroutine_mutex_t *m);
+/**
+ * Lock mutex \c m parking \c cr while it's locked by another coroutine
+ */
+void coroutine_mutex_lock(coroutine_mutex_t *m, coroutine_t *cr);
+/**
+ * Lock mutex \c m waiting for at most \c timeout nanoseconds
+ * \return \c true if mutex was locked
+ */
+bool coroutine_mutex_lock_for(coroutine_mutex_t *m, coroutine_t *cr,
+                              uint64_t timeout);
+/**
+ * \return \c true if mutex was locked
+ */
+bool coroutine_mutex_trylock(coroutine_mutex_t *m);
+/**
+ * Unlock mutex \c m or hand it over to the first waiter
+ */
+void coroutine_mutex_unlock(coroutine_mutex_t *m);
+
+/**** semaphore ****/
+void coroutine_sem_init(coroutine_sem_t *s, size_t count);
+void coroutine_sem_deinit(coroutine_sem_t *s);
+/**
+ * Decrement semaphore \c s parking \c cr while its count is zero
+ */
+void coroutine_sem_wait(coroutine_sem_t *s, coroutine_t *cr);
+/**
+ * Decrement semaphore \c s waiting for at most \c timeout nanoseconds
+ * \return \c true if semaphore was decremented
+ */
+bool coroutine_sem_wait_for(coroutine_sem_t *s, coroutine_t *cr,
+                            uint64_t timeout);
+/**
+ * \return \c true if semaphore was decremented
+ */
+bool coroutine_sem_trywait(coroutine_sem_t *s);
+/**
+ * Increment semaphore \c s or hand the permit over to the first waiter
+ */
+void coroutine_sem_post(coroutine_sem_t *s);
+
+/**** condition variable ****/
+void coroutine_cond_init(coroutine_cond_t *c);
+void coroutine_cond_deinit(coroutine_cond_t *c);
+/**
+ * Unlock \c m and park \c cr until signalled, lock \c m again then.
+ * Spurious wakeups do not happen but the condition should be rechecked
+ * as another coroutine may take the mutex first.
+ */
+void coroutine_cond_wait(coroutine_cond_t *c, coroutine_mutex_t *m,
+                         coroutine_t *cr);
+/**
+ * Same as \c coroutine_cond_wait but wait for at most \c timeout
+ * nanoseconds, \c m is locked again in either case
+ * \return \c true if signalled
+ */
+bool coroutine_cond_wait_for(coroutine_cond_t *c, coroutine_mutex_t *m,
+                             coroutine_t *cr, uint64_t timeout);
+void coroutine_cond_signal(coroutine_cond_t *c);
+void coroutine_cond_broadcast(coroutine_cond_t *c);
+
+/**** wait group ****/
+void coroutine_wait_group_init(coroutine_wait_group_t *wg);
+void coroutine_wait_group_deinit(coroutine_wait_group_t *wg);
+/**
+ * Add \c count to the number of outstanding jobs
+ */
+void coroutine_wait_group_add(coroutine_wait_group_t *wg, size_t count);
+/**
+ * Mark one job done, the last one wakes every waiter
+ */
+void coroutine_wait_group_done(coroutine_wait_group_t *wg);
+/**
+ * Park \c cr until there are no outstanding jobs
+ */
+void coroutine_wait_group_wait(coroutine_wait_group_t *wg, coroutine_t *cr);
+/**
+ * Park \c cr until there are no outstanding jobs
+ * or \c timeout nanoseconds pass
+ * \return \c true if there are no outstanding jobs
+ */
+bool coroutine_wait_group_wait_for(coroutine_wait_group_t *wg,
+                                   coroutine_t *cr, uint64_t timeout);
+
+# ifdef __cplusplus
+}
+# endif
+
+#endif /* _COROUTINE_SYNC_H_ */
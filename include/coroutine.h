@@ -2,10 +2,22 @@
 # define _COROUTINE_H_
 
 # include "containers.h"
+# include "coroutine-config.h"
 
-# include <ucontext.h>
 # include <stddef.h>
 # include <stdint.h>
+# include <stdatomic.h>
+
+/* Hand-written context switch is used on platforms known to the library.
+ * Build with WITH_UCONTEXT_COROUTINES to fall back to ucontext, the choice
+ * is recorded in installed coroutine-config.h.
+ */
+# if !defined(COROUTINE_USE_UCONTEXT) && \
+     (defined(__x86_64__) || defined(__aarch64__))
+#  define COROUTINE_FAST_SWITCH
+# else
+#  include <ucontext.h>
+# endif
 
 # ifdef __cplusplus
 extern "C" {
@@ -14,27 +26,344 @@ extern "C" {
 struct coroutine;
 typedef struct coroutine coroutine_t;
 
+struct coroutine_stack;
+typedef struct coroutine_stack coroutine_stack_t;
+
+struct coroutine_stack_pool;
+typedef struct coroutine_stack_pool coroutine_stack_pool_t;
+
+struct coroutine_scheduler;
+
+struct coroutine_scope;
+typedef struct coroutine_scope coroutine_scope_t;
+
 typedef void (*coroutine_cb_t)(coroutine_t *cr, void *ctx);
 
+enum coroutine_sched_state {
+    CR_SCHED_RUNNABLE = 0,
+    CR_SCHED_RUNNING,
+    CR_SCHED_PARKED,
+    /* unparked while running or queued, next park returns at once */
+    CR_SCHED_NOTIFIED
+};
+
+enum coroutine_sched_request {
+    CR_SCHED_REQ_YIELD = 0,
+    CR_SCHED_REQ_PARK
+};
+
+# ifdef COROUTINE_FAST_SWITCH
+/** Saved execution context.
+ * Callee-saved registers are stored on the suspended stack itself,
+ * only the stack pointer is kept here.
+ */
+typedef struct coroutine_context {
+    void *sp;
+} coroutine_context_t;
+# else
+typedef ucontext_t coroutine_context_t;
+# endif
+
+/** Coroutine stack.
+ * Anonymous private mapping with \c PROT_NONE guard page below the usable
+ * memory. Pages are committed by kernel on first touch.
+ */
+struct coroutine_stack {
+    /* whole mapping, guard page included */
+    void *map;
+    size_t map_size;
+    /* usable memory */
+    void *data;
+    size_t size;
+    /* filled with COROUTINE_STACK_PAINT on allocation */
+    bool painted;
+};
+
+/** Stack pool statistics.
+ * Usage is recorded for painted stacks when they are released.
+ */
+typedef struct coroutine_stack_stats {
+    size_t allocated;
+    size_t mapped;
+    size_t released;
+    size_t measured;
+    size_t usage_max;
+    size_t usage_total;
+} coroutine_stack_stats_t;
+
+/** Cache of released coroutine stacks.
+ * Cached stacks are linked through a header at their top.
+ * Pool is not thread-safe.
+ */
+struct coroutine_stack_pool {
+    void *cached;
+    size_t cached_count;
+    size_t max_cached;
+    /* paint stacks so that their usage is measured exactly */
+    bool paint;
+    coroutine_stack_stats_t stats;
+};
+
+# define COROUTINE_STACK_PAINT                      0xcd
+
+# define COROUTINE_STACK_POOL_DEFAULT_MAX_CACHED    64
+
+/* coroutine-local storage slots */
+# define COROUTINE_LOCALS_MAX                       16
+
+typedef size_t coroutine_key_t;
+
+/** Cache of finished coroutines with their stacks.
+ * Coroutines are reused by resetting their context only.
+ * Pool is not thread-safe.
+ */
+typedef struct coroutine_pool {
+    /* coroutine_t *, max_cached of them */
+    buffer_t cached;
+    size_t cached_count;
+    size_t stack_size;
+    size_t max_cached;
+} coroutine_pool_t;
+
+/** Group of child coroutines driven and joined together.
+ * Children are allocated in place within \c children list elements.
+ */
+struct coroutine_scope {
+    list_t children;
+    bool cancelled;
+};
+
 struct coroutine {
-    buffer_t stack;
+    coroutine_stack_t stack;
+    /* stack is returned here, nil stands for thread's local pool */
+    coroutine_stack_pool_t *stack_pool;
 
-    ucontext_t caller;
-    ucontext_t callee;
+    coroutine_context_t caller;
+    coroutine_context_t callee;
+    /* context to switch to on yield or return,
+     * caller of the coroutine control was transferred from otherwise */
+    coroutine_context_t *resume;
 
     coroutine_cb_t cb;
     void *ctx;
 
     bool returned;
+
+    /* generator value handed over to consumer */
+    void *yielded;
+    /* coroutine was cancelled, or consumer asked generator to stop */
+    bool stop_requested;
+    /* scope the coroutine was spawned in, nil otherwise */
+    coroutine_scope_t *scope;
+
+    /* scheduler the coroutine was spawned on, nil when driven by hand */
+    struct coroutine_scheduler *sched;
+    /* enum coroutine_sched_state */
+    atomic_int sched_state;
+    /* enum coroutine_sched_request, what worker should do after yield */
+    int sched_request;
+    /* links runnable coroutine into scheduler's injection queue */
+    ilist_link_t sched_link;
+    /* scheduler destroys the coroutine once the last reference is released */
+    atomic_int refs;
+    /* position in scheduler's timer heap, SIZE_MAX if no timer is armed */
+    size_t timer_idx;
+
+    /* coroutine-local storage indexed by coroutine_key_t */
+    void *locals[COROUTINE_LOCALS_MAX];
 };
 
+/**
+ * Initialize stack pool which keeps up to \c max_cached released stacks
+ */
+void coroutine_stack_pool_init(coroutine_stack_pool_t *pool,
+                               size_t max_cached);
+/**
+ * Unmap every cached stack
+ */
+void coroutine_stack_pool_deinit(coroutine_stack_pool_t *pool);
+/**
+ * Fetch calling thread's local stack pool.
+ * The pool is created on first use and destroyed on thread exit.
+ */
+coroutine_stack_pool_t *coroutine_stack_pool_local(void);
+/**
+ * Allocate stack of at least \c size bytes either from cache of \c pool
+ * or with a new mapping. \c size is rounded up to page size.
+ */
+void coroutine_stack_alloc(coroutine_stack_pool_t *pool,
+                           coroutine_stack_t *st, size_t size);
+/**
+ * Return stack to \c pool or unmap it if the pool is full
+ */
+void coroutine_stack_release(coroutine_stack_pool_t *pool,
+                             coroutine_stack_t *st);
+/**
+ * Enable or disable painting of stacks allocated from \c pool.
+ * Painting touches every page of the stack, so it costs the whole
+ * stack size of memory. Use it to find out stack size actually needed.
+ */
+void coroutine_stack_pool_set_paint(coroutine_stack_pool_t *pool,
+                                    bool paint);
+/**
+ * Measure the deepest usage of stack \c st.
+ * Painted stack is measured exactly.
+ * Otherwise resident pages are counted which is an upper bound
+ * with page granularity, reused stacks keep pages of the previous user.
+ */
+size_t coroutine_stack_used(const coroutine_stack_t *st);
+/**
+ * Measure the deepest usage of coroutine's \c cr stack,
+ * see \c coroutine_stack_used
+ */
+size_t coroutine_stack_usage(const coroutine_t *cr);
+
+/**
+ * Initialize coroutine with stack from thread's local stack pool
+ */
 void coroutine_init(coroutine_t *cr,
                     coroutine_cb_t cb, void *ctx,
                     size_t stack_size);
+/**
+ * Initialize coroutine with stack from \c pool.
+ * Nil \c pool stands for local pool of the thread calling
+ * \c coroutine_init_pooled or \c coroutine_deinit respectively.
+ */
+void coroutine_init_pooled(coroutine_t *cr,
+                           coroutine_cb_t cb, void *ctx,
+                           size_t stack_size,
+                           coroutine_stack_pool_t *pool);
+/**
+ * Make coroutine \c cr run \c cb from the start again keeping its stack.
+ * Coroutine should not be running.
+ */
+void coroutine_reset(coroutine_t *cr, coroutine_cb_t cb, void *ctx);
 void coroutine_deinit(coroutine_t *cr);
 void coroutine_continue(coroutine_t *cr);
 bool coroutine_returned(const coroutine_t *cr);
-void coroutine_yield(coroutine_t *cr);
+/**
+ * Switch back to whoever continued coroutine \c cr.
+ * Should be called from within \c cr.
+ * \return \c false if the coroutine was cancelled,
+ *         it should clean up and return then
+ */
+bool coroutine_yield(coroutine_t *cr);
+/**
+ * Request cancellation of coroutine \c cr.
+ * It is delivered as \c false returned by the next \c coroutine_yield.
+ */
+void coroutine_cancel(coroutine_t *cr);
+bool coroutine_cancelled(const coroutine_t *cr);
+/**
+ * Switch from running coroutine \c from straight to coroutine \c to.
+ * Should be called from within \c from.
+ * The next yield or return of \c to resumes whoever continued \c from,
+ * so \c from should not be continued until then.
+ * Both coroutines should be driven by hand rather than by a scheduler.
+ */
+void coroutine_transfer(coroutine_t *from, coroutine_t *to);
+
+/**
+ * Fetch coroutine run by the calling thread
+ * \return innermost running coroutine or \c NULL if called outside of any
+ */
+coroutine_t *coroutine_current(void);
+
+/**** coroutine-local storage ****/
+/**
+ * Register coroutine-local storage key.
+ * Keys are never released, register them once at start up.
+ * \return \c false if all of COROUTINE_LOCALS_MAX keys are taken
+ */
+bool coroutine_key_create(coroutine_key_t *key);
+/**
+ * Fetch value of \c key in coroutine \c cr, \c NULL if it was never set
+ */
+void *coroutine_local_get(const coroutine_t *cr, coroutine_key_t key);
+void coroutine_local_set(coroutine_t *cr, coroutine_key_t key, void *value);
+
+/**** coroutine pool ****/
+/**
+ * Initialize pool of coroutines with stacks of \c stack_size bytes
+ * keeping up to \c max_cached finished ones
+ */
+void coroutine_pool_init(coroutine_pool_t *pool, size_t stack_size,
+                         size_t max_cached);
+/**
+ * Destroy every cached coroutine
+ */
+void coroutine_pool_deinit(coroutine_pool_t *pool);
+/**
+ * Take coroutine from \c pool and arm it with \c cb and \c ctx,
+ * new one is allocated if none is cached.
+ * Stack comes from local stack pool of the calling thread.
+ */
+coroutine_t *coroutine_pool_get(coroutine_pool_t *pool,
+                                coroutine_cb_t cb, void *ctx);
+/**
+ * Put coroutine \c cr taken from \c pool back.
+ * Coroutine should not be running, it's destroyed if pool is full.
+ */
+void coroutine_pool_put(coroutine_pool_t *pool, coroutine_t *cr);
+
+/**** scopes ****/
+void coroutine_scope_init(coroutine_scope_t *scope);
+/**
+ * Cancel and join outstanding children
+ */
+void coroutine_scope_deinit(coroutine_scope_t *scope);
+/**
+ * Create child coroutine in \c scope, it's run by the next step or join.
+ * Child spawned in cancelled scope is cancelled at once.
+ * \return child coroutine which is destroyed by the scope after it returns
+ */
+coroutine_t *coroutine_scope_spawn(coroutine_scope_t *scope,
+                                   coroutine_cb_t cb, void *ctx,
+                                   size_t stack_size);
+/**
+ * Continue every outstanding child once and destroy returned ones.
+ * Lets caller check for a deadline between steps.
+ * \return number of outstanding children
+ */
+size_t coroutine_scope_step(coroutine_scope_t *scope);
+/**
+ * Step \c scope until all of its children return
+ */
+void coroutine_scope_join(coroutine_scope_t *scope);
+/**
+ * Cancel every outstanding child of \c scope.
+ * May be called by a failing child, see \c coroutine_scope.
+ */
+void coroutine_scope_cancel(coroutine_scope_t *scope);
+bool coroutine_scope_cancelled(const coroutine_scope_t *scope);
+/**
+ * Fetch scope coroutine \c cr was spawned in
+ * \return scope or \c NULL if coroutine was initialized by hand
+ */
+coroutine_scope_t *coroutine_scope(const coroutine_t *cr);
+
+/**** generators ****/
+/**
+ * Hand \c value over to consumer and suspend generator \c cr.
+ * Should be called from within \c cr.
+ * \return \c false if consumer asked generator to stop,
+ *         generator should clean up and return then
+ */
+bool generator_yield_value(coroutine_t *cr, void *value);
+/**
+ * Resume generator \c cr until it yields the next value
+ * \return pointer passed to \c generator_yield_value or \c NULL
+ *         if the generator returned, see \c generator_done
+ */
+void *generator_next(coroutine_t *cr);
+/**
+ * \return \c true if generator returned and has no more values
+ */
+bool generator_done(const coroutine_t *cr);
+/**
+ * Ask generator \c cr to stop and resume it until it returns
+ */
+void generator_stop(coroutine_t *cr);
 
 # ifdef __cplusplus
 }
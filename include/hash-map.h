@@ -48,8 +48,22 @@ typedef list_element_t hash_map_node_element_t;
 void hash_map_init(hash_map_t *hm,
                    hash_function_t hasher,
                    hash_update_function_t hash_updater);
+/* tree nodes and data lists are allocated by allocator,
+ * nil allocator stands for allocator_default */
+void hash_map_init_allocator(hash_map_t *hm,
+                             hash_function_t hasher,
+                             hash_update_function_t hash_updater,
+                             const allocator_t *allocator);
 void hash_map_purge(hash_map_t *hm);
+# ifdef CONTAINERS_INLINE_DEFINITIONS
+inline
+size_t hash_map_size(hash_map_t *hm) {
+    CONTAINERS_CHECK(hm);
+    return hm->tree.count;
+}
+# else
 size_t hash_map_size(hash_map_t *hm);
+# endif
 hash_map_node_t *hash_map_add(hash_map_t *hm, hash_t h);
 hash_map_node_t *hash_map_add_or_get(hash_map_t *hm, hash_t h);
 hash_map_node_t *hash_map_get(hash_map_t *hm, hash_t h);
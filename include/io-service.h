@@ -5,6 +5,8 @@
 # include "avl-tree.h"
 
 # include <stdbool.h>
+# include <stdint.h>
+# include <time.h>
 # include <pthread.h>
 # include <sys/epoll.h>
 # include <stdatomic.h>
@@ -25,6 +27,9 @@ typedef struct iosvc_fd_desc iosvc_fd_desc_t;
 struct iosvc_enqueued_op;
 typedef struct iosvc_enqueued_op iosvc_enqueued_op_t;
 
+struct iosvc_rate_limiter;
+typedef struct iosvc_rate_limiter iosvc_rate_limiter_t;
+
 enum io_service_operation;
 
 typedef void (*iosvc_fd_op_t)(int fd, enum io_service_operation op,
@@ -64,6 +69,11 @@ struct iosvc_fd_desc {
     struct epoll_event event;
 
     iosvc_op_desc_t op[IO_SVC_OP_COUNT + 1];    /* one more for masked */
+
+    /* rate limiter the fd is charged to, if any */
+    iosvc_rate_limiter_t *limiter;
+    /* fd is removed from epoll until the limiter refills */
+    bool suspended;
 };
 
 struct iosvc_enqueued_op {
@@ -72,6 +82,36 @@ struct iosvc_enqueued_op {
     bool fresh;
 };
 
+/** Token bucket.
+ * Zero \c rate means the bucket is unlimited.
+ * \c tokens may become negative when more is consumed than was available.
+ */
+typedef struct iosvc_token_bucket {
+    double rate;        /* tokens per second */
+    double burst;       /* bucket capacity */
+    double tokens;
+} iosvc_token_bucket_t;
+
+/** Rate limiter shared by any number of fds of a single io service.
+ * Each dispatched event costs one operation token, bytes are charged
+ * by user with \c io_service_rate_limiter_consume.
+ * When any bucket runs empty the fd being dispatched is removed from epoll
+ * and the limiter's timer fd is armed to put it back once the bucket refills.
+ */
+struct iosvc_rate_limiter {
+    io_service_t *iosvc;
+
+    iosvc_token_bucket_t ops;
+    iosvc_token_bucket_t bytes;
+    struct timespec last_refill;
+
+    int timer_fd;
+    bool timer_armed;
+
+    /* list of suspended fds (int) */
+    list_t suspended;
+};
+
 struct io_service {
     /* fd -> iosvc_fd_desc_t */
     avl_tree_t fd_map;
@@ -81,6 +121,9 @@ struct io_service {
     bool allow_new_jobs;
     bool running_enqueued;
 
+    /* timer fds of rate limiters, they don't keep the service running */
+    unsigned int rate_limiters;
+
     int event_fd;
     int epoll_fd;
 
@@ -107,6 +150,33 @@ void io_service_deinit(io_service_t *iosvc);
 void io_service_run(io_service_t *iosvc);
 void io_service_stop(io_service_t *iosvc, bool wait_pending);
 
+/**
+ * Initialize rate limiter \c rl for io service \c iosvc.
+ * Zero \c ops_per_sec or \c bytes_per_sec disables the respective bucket.
+ * Zero burst defaults to one second worth of tokens.
+ */
+void io_service_rate_limiter_init(io_service_t *iosvc,
+                                  iosvc_rate_limiter_t *rl,
+                                  uint64_t ops_per_sec, uint64_t ops_burst,
+                                  uint64_t bytes_per_sec, uint64_t bytes_burst);
+/**
+ * Detach rate limiter from every fd charged to it, resume suspended ones
+ * and release its resources.
+ * Safe to call while io service is running, \c rl may be freed on return.
+ */
+void io_service_rate_limiter_deinit(iosvc_rate_limiter_t *rl);
+/**
+ * Charge already watched \c fd to rate limiter \c rl.
+ * \c rl equal to nil detaches the fd from its limiter.
+ * The association is dropped when the fd is unwatched.
+ */
+void io_service_set_fd_rate_limiter(io_service_t *iosvc, int fd,
+                                    iosvc_rate_limiter_t *rl);
+/**
+ * Charge \c bytes transferred to byte bucket of rate limiter \c rl
+ */
+void io_service_rate_limiter_consume(iosvc_rate_limiter_t *rl, size_t bytes);
+
 # ifdef __cplusplus
 }
 # endif
@@ -2,6 +2,7 @@
 # define _SET_H_
 
 # include "avl-tree.h"
+# include "containers-inline.h"
 
 # include <stdbool.h>
 # include <stddef.h>
@@ -25,9 +26,19 @@ typedef struct set_iterator {
 } set_iterator_t;
 
 void set_init(set_t *s);
+/* nil allocator stands for allocator_default */
+void set_init_allocator(set_t *s, const allocator_t *allocator);
 void set_purge(set_t *s);
 
+# ifdef CONTAINERS_INLINE_DEFINITIONS
+inline
+size_t set_size(set_t *s) {
+    CONTAINERS_CHECK(s);
+    return s->tree.count;
+}
+# else
 size_t set_size(set_t *s);
+# endif
 set_counter_t set_add(set_t *s, set_key_t k);
 set_counter_t set_add_single(set_t *s, set_key_t k);
 set_counter_t set_count(set_t *s, set_key_t k);
@@ -38,8 +49,22 @@ set_iterator_t set_end(set_t *s);
 set_iterator_t set_next(set_t *s, avl_tree_node_t *el);
 set_iterator_t set_prev(set_t *s, avl_tree_node_t *el);
 
+# ifdef CONTAINERS_INLINE_DEFINITIONS
+inline
+set_key_t set_get_data(avl_tree_node_t *el) {
+    return el ? el->key : 0;
+}
+# else
 set_key_t set_get_data(avl_tree_node_t *el);
+# endif
+# ifdef CONTAINERS_INLINE_DEFINITIONS
+inline
+set_counter_t set_data_count(avl_tree_node_t *el) {
+    return el ? *(set_counter_t *)el->data : 0;
+}
+# else
 set_counter_t set_data_count(avl_tree_node_t *el);
+# endif
 
 # ifdef __cplusplus
 }
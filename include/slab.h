@@ -0,0 +1,75 @@
+#ifndef _SLAB_H_
+# define _SLAB_H_
+
+/** \file slab.h
+ * Slab allocator for fixed-size objects.
+ * Objects are carved from large slabs on demand, released ones
+ * are kept in a free list. Every slab is released at once on reset.
+ * Not thread-safe.
+ */
+
+# include "allocator.h"
+
+# include <stdbool.h>
+# include <stddef.h>
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+# define SLAB_DEFAULT_SIZE      (64 * 1024)
+/* objects are aligned on this boundary */
+# define SLAB_ALIGN             (2 * sizeof(void *))
+
+typedef struct slab_cache {
+    size_t object_size;
+    size_t slab_size;
+    /* chain of allocated slabs */
+    void *slabs;
+    size_t slabs_count;
+    /* chain of released objects */
+    void *free;
+    /* not yet carved part of the newest slab */
+    char *carve;
+    char *carve_end;
+    /* objects in use */
+    size_t count;
+    /* slabs are allocated with */
+    const allocator_t *allocator;
+} slab_cache_t;
+
+/**
+ * Initialize cache of objects of \c object_size bytes.
+ * Slabs are \c slab_size bytes, zero stands for \c SLAB_DEFAULT_SIZE.
+ * Slab is enlarged to fit at least a few objects.
+ */
+void slab_cache_init(slab_cache_t *c, size_t object_size, size_t slab_size);
+/**
+ * Initialize cache with slabs allocated by \c allocator.
+ * Nil \c allocator stands for \c allocator_default.
+ */
+void slab_cache_init_allocator(slab_cache_t *c, size_t object_size,
+                               size_t slab_size, const allocator_t *allocator);
+/**
+ * Release every slab
+ */
+void slab_cache_deinit(slab_cache_t *c);
+/**
+ * Release every slab at once, every object allocated is invalid afterwards.
+ * Cache remains usable.
+ */
+void slab_cache_reset(slab_cache_t *c);
+/**
+ * Allocate object
+ */
+void *slab_alloc(slab_cache_t *c);
+/**
+ * Put object \c obj back to cache \c c it was allocated from
+ */
+void slab_free(slab_cache_t *c, void *obj);
+
+# ifdef __cplusplus
+}
+# endif
+
+#endif /* _SLAB_H_ */
@@ -0,0 +1,434 @@
+#ifndef _TYPED_CONTAINERS_H_
+# define _TYPED_CONTAINERS_H_
+
+/** \file typed-containers.h
+ * Type-specialized containers generated by macros.
+ * Every function is static inline and works on concrete types, so that
+ * element sizes and comparisons are known to the compiler.
+ *
+ * \c DECLARE_VECTOR(name, T) declares \c name_t, a vector of \c T:
+ *  - \c name_init, \c name_init_allocator, \c name_deinit
+ *  - \c name_size, \c name_capacity, \c name_reserve, \c name_clear
+ *  - \c name_get, \c name_begin, \c name_end
+ *  - \c name_append, \c name_push_back, \c name_append_n, \c name_insert
+ *  - \c name_remove, \c name_pop_back
+ *
+ * \c DECLARE_AVL(name, K, V, cmp) declares \c name_t, an AVL tree mapping
+ * keys of \c K to values of \c V stored in nodes of \c name_node_t.
+ * \c cmp(a, b) is a function or macro returning negative, zero or positive
+ * value if key \c a is less than, equal to or greater than key \c b,
+ * see \c TYPED_CMP_SCALAR:
+ *  - \c name_init, \c name_init_allocator, \c name_purge, \c name_size
+ *  - \c name_find, \c name_get, \c name_insert, \c name_remove
+ *  - \c name_first, \c name_last, \c name_next, \c name_prev
+ *
+ * Neither is thread-safe.
+ */
+
+# include "allocator.h"
+
+# include <assert.h>
+# include <stdbool.h>
+# include <stddef.h>
+# include <string.h>
+
+/**
+ * Comparison of scalar keys for \c DECLARE_AVL
+ */
+# define TYPED_CMP_SCALAR(a, b)     (((a) > (b)) - ((a) < (b)))
+
+/* initial capacity of typed vector */
+# define TYPED_VECTOR_MIN_CAPACITY  8
+
+/***************************** VECTOR *****************************/
+# define DECLARE_VECTOR(name, T)                                            \
+typedef struct name {                                                       \
+    T *data;                                                                \
+    size_t count;                                                           \
+    size_t capacity;                                                        \
+    const allocator_t *allocator;                                           \
+} name##_t;                                                                 \
+                                                                            \
+static inline                                                               \
+void name##_init_allocator(name##_t *v, const allocator_t *allocator) {     \
+    assert(v);                                                              \
+    v->data = NULL;                                                         \
+    v->count = v->capacity = 0;                                             \
+    v->allocator = allocator ? allocator : &allocator_default;              \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+void name##_init(name##_t *v) {                                             \
+    name##_init_allocator(v, NULL);                                         \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+void name##_deinit(name##_t *v) {                                           \
+    assert(v);                                                              \
+    if (v->data)                                                            \
+        allocator_free(v->allocator, v->data, v->capacity * sizeof(T));    \
+    v->data = NULL;                                                         \
+    v->count = v->capacity = 0;                                             \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+size_t name##_size(const name##_t *v) {                                     \
+    return v->count;                                                        \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+size_t name##_capacity(const name##_t *v) {                                 \
+    return v->capacity;                                                     \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+void name##_reserve(name##_t *v, size_t count) {                            \
+    T *d;                                                                   \
+    if (count <= v->capacity)                                               \
+        return;                                                             \
+    d = allocator_realloc(v->allocator, v->data,                            \
+                          v->capacity * sizeof(T), count * sizeof(T));      \
+    assert(d);                                                              \
+    v->data = d;                                                            \
+    v->capacity = count;                                                    \
+}                                                                           \
+                                                                            \
+/* make room for count more elements */                                     \
+static inline                                                               \
+void name##_grow(name##_t *v, size_t count) {                               \
+    size_t cap = v->capacity ? v->capacity : TYPED_VECTOR_MIN_CAPACITY;     \
+    if (v->count + count <= v->capacity)                                    \
+        return;                                                             \
+    while (cap < v->count + count)                                          \
+        cap *= 2;                                                           \
+    name##_reserve(v, cap);                                                 \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+void name##_clear(name##_t *v) {                                            \
+    v->count = 0;                                                           \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+T *name##_get(name##_t *v, size_t idx) {                                    \
+    assert(idx < v->count);                                                 \
+    return v->data + idx;                                                   \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+T *name##_begin(name##_t *v) {                                              \
+    return v->data;                                                         \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+T *name##_end(name##_t *v) {                                                \
+    return v->data + v->count;                                              \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+T *name##_append(name##_t *v) {                                             \
+    name##_grow(v, 1);                                                      \
+    return v->data + v->count++;                                            \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+void name##_push_back(name##_t *v, T el) {                                  \
+    *name##_append(v) = el;                                                 \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+T *name##_append_n(name##_t *v, const T *src, size_t count) {               \
+    T *d;                                                                   \
+    name##_grow(v, count);                                                  \
+    d = v->data + v->count;                                                 \
+    if (src)                                                                \
+        memcpy(d, src, count * sizeof(T));                                  \
+    v->count += count;                                                      \
+    return d;                                                               \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+T *name##_insert(name##_t *v, size_t idx) {                                 \
+    assert(idx <= v->count);                                                \
+    name##_grow(v, 1);                                                      \
+    memmove(v->data + idx + 1, v->data + idx,                               \
+            (v->count - idx) * sizeof(T));                                  \
+    ++v->count;                                                             \
+    return v->data + idx;                                                   \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+void name##_remove(name##_t *v, size_t idx) {                               \
+    assert(idx < v->count);                                                 \
+    --v->count;                                                             \
+    memmove(v->data + idx, v->data + idx + 1,                               \
+            (v->count - idx) * sizeof(T));                                  \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+bool name##_pop_back(name##_t *v, T *el) {                                  \
+    if (!v->count)                                                          \
+        return false;                                                       \
+    --v->count;                                                             \
+    if (el)                                                                 \
+        *el = v->data[v->count];                                            \
+    return true;                                                            \
+}
+
+/***************************** AVL TREE *****************************/
+# define DECLARE_AVL(name, K, V, cmp)                                       \
+typedef struct name##_node {                                                \
+    K key;                                                                  \
+    V value;                                                                \
+    struct name##_node *left;                                               \
+    struct name##_node *right;                                              \
+    struct name##_node *parent;                                             \
+    int height;                                                             \
+} name##_node_t;                                                            \
+                                                                            \
+typedef struct name {                                                       \
+    name##_node_t *root;                                                    \
+    size_t count;                                                           \
+    const allocator_t *allocator;                                           \
+} name##_t;                                                                 \
+                                                                            \
+static inline                                                               \
+int name##_height(const name##_node_t *n) {                                 \
+    return n ? n->height : 0;                                               \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+void name##_update(name##_node_t *n) {                                      \
+    int l = name##_height(n->left);                                         \
+    int r = name##_height(n->right);                                        \
+    n->height = (l > r ? l : r) + 1;                                        \
+}                                                                           \
+                                                                            \
+/* put v in place of u in u's parent */                                     \
+static inline                                                               \
+void name##_replace(name##_t *t, name##_node_t *u, name##_node_t *v) {      \
+    if (!u->parent)                                                         \
+        t->root = v;                                                        \
+    else if (u == u->parent->left)                                          \
+        u->parent->left = v;                                                \
+    else                                                                    \
+        u->parent->right = v;                                               \
+    if (v)                                                                  \
+        v->parent = u->parent;                                              \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+void name##_rotate_left(name##_t *t, name##_node_t *x) {                    \
+    name##_node_t *y = x->right;                                            \
+    x->right = y->left;                                                     \
+    if (y->left)                                                            \
+        y->left->parent = x;                                                \
+    name##_replace(t, x, y);                                                \
+    y->left = x;                                                            \
+    x->parent = y;                                                          \
+    name##_update(x);                                                       \
+    name##_update(y);                                                       \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+void name##_rotate_right(name##_t *t, name##_node_t *x) {                   \
+    name##_node_t *y = x->left;                                             \
+    x->left = y->right;                                                     \
+    if (y->right)                                                           \
+        y->right->parent = x;                                               \
+    name##_replace(t, x, y);                                                \
+    y->right = x;                                                           \
+    x->parent = y;                                                          \
+    name##_update(x);                                                       \
+    name##_update(y);                                                       \
+}                                                                           \
+                                                                            \
+/* restore balance from n up to the root */                                 \
+static inline                                                               \
+void name##_rebalance(name##_t *t, name##_node_t *n) {                      \
+    int balance;                                                            \
+    for (; n; n = n->parent) {                                              \
+        name##_update(n);                                                   \
+        balance = name##_height(n->left) - name##_height(n->right);         \
+        if (balance > 1) {                                                  \
+            if (name##_height(n->left->left) <                              \
+                name##_height(n->left->right))                              \
+                name##_rotate_left(t, n->left);                             \
+            name##_rotate_right(t, n);                                      \
+            n = n->parent;                                                  \
+        }                                                                   \
+        else if (balance < -1) {                                            \
+            if (name##_height(n->right->right) <                            \
+                name##_height(n->right->left))                              \
+                name##_rotate_right(t, n->right);                           \
+            name##_rotate_left(t, n);                                       \
+            n = n->parent;                                                  \
+        }                                                                   \
+    }                                                                       \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+void name##_init_allocator(name##_t *t, const allocator_t *allocator) {     \
+    assert(t);                                                              \
+    t->root = NULL;                                                         \
+    t->count = 0;                                                           \
+    t->allocator = allocator ? allocator : &allocator_default;              \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+void name##_init(name##_t *t) {                                             \
+    name##_init_allocator(t, NULL);                                         \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+size_t name##_size(const name##_t *t) {                                     \
+    return t->count;                                                        \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+name##_node_t *name##_first(const name##_t *t) {                            \
+    name##_node_t *n = t->root;                                             \
+    if (n)                                                                  \
+        while (n->left)                                                     \
+            n = n->left;                                                    \
+    return n;                                                               \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+name##_node_t *name##_last(const name##_t *t) {                             \
+    name##_node_t *n = t->root;                                             \
+    if (n)                                                                  \
+        while (n->right)                                                    \
+            n = n->right;                                                   \
+    return n;                                                               \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+name##_node_t *name##_next(name##_node_t *n) {                              \
+    if (n->right) {                                                         \
+        for (n = n->right; n->left; n = n->left);                           \
+        return n;                                                           \
+    }                                                                       \
+    while (n->parent && n == n->parent->right)                              \
+        n = n->parent;                                                      \
+    return n->parent;                                                       \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+name##_node_t *name##_prev(name##_node_t *n) {                              \
+    if (n->left) {                                                          \
+        for (n = n->left; n->right; n = n->right);                          \
+        return n;                                                           \
+    }                                                                       \
+    while (n->parent && n == n->parent->left)                               \
+        n = n->parent;                                                      \
+    return n->parent;                                                       \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+void name##_purge(name##_t *t) {                                            \
+    name##_node_t *n = t->root, *p;                                         \
+    /* memory goes back in bulk with allocator */                           \
+    if (!t->allocator->free)                                                \
+        n = NULL;                                                           \
+    /* post-order walk, each node is released after its children */         \
+    while (n) {                                                             \
+        if (n->left)                                                        \
+            n = n->left;                                                    \
+        else if (n->right)                                                  \
+            n = n->right;                                                   \
+        else {                                                              \
+            p = n->parent;                                                  \
+            if (p)                                                          \
+                *(p->left == n ? &p->left : &p->right) = NULL;              \
+            allocator_free(t->allocator, n, sizeof(*n));                    \
+            n = p;                                                          \
+        }                                                                   \
+    }                                                                       \
+    t->root = NULL;                                                         \
+    t->count = 0;                                                           \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+name##_node_t *name##_find(const name##_t *t, K key) {                      \
+    name##_node_t *n = t->root;                                             \
+    int c;                                                                  \
+    while (n) {                                                             \
+        c = cmp(key, n->key);                                               \
+        if (!c)                                                             \
+            return n;                                                       \
+        n = c < 0 ? n->left : n->right;                                     \
+    }                                                                       \
+    return NULL;                                                            \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+V *name##_get(const name##_t *t, K key) {                                   \
+    name##_node_t *n = name##_find(t, key);                                 \
+    return n ? &n->value : NULL;                                            \
+}                                                                           \
+                                                                            \
+/* value of newly inserted node is left uninitialized */                    \
+static inline                                                               \
+V *name##_insert(name##_t *t, K key, bool *inserted) {                      \
+    name##_node_t **link = &t->root, *parent = NULL, *n;                    \
+    int c;                                                                  \
+    while (*link) {                                                         \
+        parent = *link;                                                     \
+        c = cmp(key, parent->key);                                          \
+        if (!c) {                                                           \
+            if (inserted)                                                   \
+                *inserted = false;                                          \
+            return &parent->value;                                          \
+        }                                                                   \
+        link = c < 0 ? &parent->left : &parent->right;                      \
+    }                                                                       \
+    n = allocator_alloc(t->allocator, sizeof(*n));                          \
+    assert(n);                                                              \
+    n->key = key;                                                           \
+    n->left = n->right = NULL;                                              \
+    n->parent = parent;                                                     \
+    n->height = 1;                                                          \
+    *link = n;                                                              \
+    ++t->count;                                                             \
+    name##_rebalance(t, parent);                                            \
+    if (inserted)                                                           \
+        *inserted = true;                                                   \
+    return &n->value;                                                       \
+}                                                                           \
+                                                                            \
+static inline                                                               \
+bool name##_remove(name##_t *t, K key) {                                    \
+    name##_node_t *n = name##_find(t, key), *s, *fix;                       \
+    if (!n)                                                                 \
+        return false;                                                       \
+    if (!n->left) {                                                         \
+        fix = n->parent;                                                    \
+        name##_replace(t, n, n->right);                                     \
+    }                                                                       \
+    else if (!n->right) {                                                   \
+        fix = n->parent;                                                    \
+        name##_replace(t, n, n->left);                                      \
+    }                                                                       \
+    else {                                                                  \
+        /* successor takes place of removed node */                         \
+        for (s = n->right; s->left; s = s->left);                           \
+        if (s->parent != n) {                                               \
+            fix = s->parent;                                                \
+            name##_replace(t, s, s->right);                                 \
+            s->right = n->right;                                            \
+            s->right->parent = s;                                           \
+        }                                                                   \
+        else                                                                \
+            fix = s;                                                        \
+        name##_replace(t, n, s);                                            \
+        s->left = n->left;                                                  \
+        s->left->parent = s;                                                \
+    }                                                                       \
+    name##_rebalance(t, fix);                                               \
+    allocator_free(t->allocator, n, sizeof(*n));                            \
+    --t->count;                                                             \
+    return true;                                                            \
+}
+
+#endif /* _TYPED_CONTAINERS_H_ */
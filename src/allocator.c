@@ -0,0 +1,32 @@
+#include "allocator.h"
+#include "common.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+
+static
+void *default_alloc(void *ctx, size_t size) {
+    DONT_USE(ctx);
+    return malloc(size);
+}
+
+static
+void *default_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size) {
+    DONT_USE(ctx);
+    DONT_USE(old_size);
+    return realloc(ptr, new_size);
+}
+
+static
+void default_free(void *ctx, void *ptr, size_t size) {
+    DONT_USE(ctx);
+    DONT_USE(size);
+    free(ptr);
+}
+
+const allocator_t allocator_default = {
+    .alloc      = default_alloc,
+    .realloc    = default_realloc,
+    .free       = default_free,
+    .ctx        = NULL
+};
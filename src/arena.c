@@ -0,0 +1,183 @@
+#include "arena.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+struct arena_block {
+    struct arena_block *next;
+    /* including the header */
+    size_t size;
+};
+
+#define ARENA_ROUND(x)          (((x) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+#define ARENA_HEADER_SIZE       ARENA_ROUND(sizeof(arena_block_t))
+
+/******************************* internal funcs *******************************/
+static inline
+char *block_data(arena_block_t *b) {
+    return (char *)b + ARENA_HEADER_SIZE;
+}
+
+static inline
+void use_block(arena_t *a, arena_block_t *b) {
+    a->current = b;
+    a->ptr = block_data(b);
+    a->end = (char *)b + b->size;
+}
+
+/* make current block fit at least size bytes */
+static
+void arena_grow(arena_t *a, size_t size) {
+    arena_block_t *b;
+    size_t block_size = ARENA_HEADER_SIZE + size;
+
+    /* reuse block left from rollback or reset if it's large enough */
+    b = a->current ? a->current->next : a->first;
+
+    if (b && b->size >= block_size) {
+        use_block(a, b);
+        return;
+    }
+
+    if (block_size < a->block_size)
+        block_size = a->block_size;
+
+    b = malloc(block_size);
+    assert(b);
+
+    b->size = block_size;
+
+    /* the new block goes right after current one, unused ones follow */
+    if (a->current) {
+        b->next = a->current->next;
+        a->current->next = b;
+    }
+    else {
+        b->next = a->first;
+        a->first = b;
+    }
+
+    use_block(a, b);
+}
+
+static
+void *allocator_arena_alloc(void *ctx, size_t size) {
+    return arena_alloc(ctx, size);
+}
+
+static
+void *allocator_arena_realloc(void *ctx, void *ptr,
+                              size_t old_size, size_t new_size) {
+    return arena_realloc(ctx, ptr, old_size, new_size);
+}
+
+/******************************* API *******************************/
+void arena_init(arena_t *a, size_t block_size) {
+    assert(a);
+
+    if (!block_size)
+        block_size = ARENA_DEFAULT_BLOCK_SIZE;
+
+    a->block_size = ARENA_HEADER_SIZE + ARENA_ROUND(block_size);
+    a->first = a->current = NULL;
+    a->ptr = a->end = a->last = NULL;
+
+    a->allocator.alloc = allocator_arena_alloc;
+    a->allocator.realloc = allocator_arena_realloc;
+    a->allocator.free = NULL;
+    a->allocator.ctx = a;
+}
+
+void arena_deinit(arena_t *a) {
+    arena_block_t *b, *next;
+
+    assert(a);
+
+    for (b = a->first; b; b = next) {
+        next = b->next;
+        free(b);
+    }
+
+    a->first = a->current = NULL;
+    a->ptr = a->end = a->last = NULL;
+}
+
+void *arena_alloc(arena_t *a, size_t size) {
+    assert(a);
+
+    size = ARENA_ROUND(size);
+
+    if (!a->current || (size_t)(a->end - a->ptr) < size)
+        arena_grow(a, size);
+
+    a->last = a->ptr;
+    a->ptr += size;
+
+    return a->last;
+}
+
+void *arena_realloc(arena_t *a, void *ptr, size_t old_size, size_t new_size) {
+    void *d;
+
+    assert(a);
+
+    if (!ptr)
+        return arena_alloc(a, new_size);
+
+    if (ptr == a->last &&
+        (size_t)(a->end - a->last) >= ARENA_ROUND(new_size)) {
+        a->ptr = a->last + ARENA_ROUND(new_size);
+        return ptr;
+    }
+
+    if (new_size <= old_size)
+        return ptr;
+
+    d = arena_alloc(a, new_size);
+    memcpy(d, ptr, old_size);
+
+    return d;
+}
+
+arena_checkpoint_t arena_checkpoint(const arena_t *a) {
+    arena_checkpoint_t cp;
+
+    assert(a);
+
+    cp.block = a->current;
+    cp.ptr = a->ptr;
+
+    return cp;
+}
+
+void arena_rollback(arena_t *a, arena_checkpoint_t cp) {
+    assert(a);
+
+    if (!cp.block) {
+        arena_reset(a);
+        return;
+    }
+
+    assert(cp.ptr >= block_data(cp.block) &&
+           cp.ptr <= (char *)cp.block + cp.block->size);
+
+    a->current = cp.block;
+    a->ptr = cp.ptr;
+    a->end = (char *)cp.block + cp.block->size;
+    a->last = NULL;
+}
+
+void arena_reset(arena_t *a) {
+    assert(a);
+
+    a->current = NULL;
+    a->ptr = a->end = a->last = NULL;
+}
+
+const allocator_t *arena_allocator(arena_t *a) {
+    assert(a);
+    return &a->allocator;
+}
@@ -1,41 +1,28 @@
 #include "avl-tree.h"
 
-#include <stdlib.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <assert.h>
 
-typedef avl_tree_node_t *(*node_allocator)(avl_tree_t *t, avl_tree_key_t k);
-typedef void (*node_deallocator)(avl_tree_node_t *n);
+static inline
+size_t node_size(const avl_tree_t *t) {
+    return sizeof(avl_tree_node_t) + (t->inplace ? t->node_data_size : 0);
+}
 
 static
-avl_tree_node_t *node_simple_allocator(avl_tree_t *t, avl_tree_key_t k);
-static
-avl_tree_node_t *node_inplace_allocator(avl_tree_t *t, avl_tree_key_t k);
-
-static const struct {
-    node_allocator      allocator;
-    node_deallocator    deallocator;
-} node_operators[2] = {
-    [false] = {
-        .allocator      = node_simple_allocator,
-        .deallocator    = (node_deallocator)free
-    },
-    [true] = {
-        .allocator      = node_inplace_allocator,
-        .deallocator    = (node_deallocator)free
-    }
-};
+avl_tree_node_t *node_alloc(avl_tree_t *t, avl_tree_key_t k) {
+    avl_tree_node_t *n;
 
-static
-avl_tree_node_t *node_simple_allocator(avl_tree_t *t, avl_tree_key_t k) {
-    avl_tree_node_t *n = malloc(sizeof(avl_tree_node_t));
+    if (t->slab)
+        n = slab_alloc(t->slab);
+    else
+        n = allocator_alloc(t->allocator, node_size(t));
 
     assert(n);
 
     n->height = 1;
-    n->data = NULL;
+    n->data = t->inplace ? n + 1 : NULL;
     n->host = t;
     n->key = k;
     n->left = n->right = n->parent = NULL;
@@ -43,19 +30,12 @@ avl_tree_node_t *node_simple_allocator(avl_tree_t *t, avl_tree_key_t k) {
     return n;
 }
 
-static
-avl_tree_node_t *node_inplace_allocator(avl_tree_t *t, avl_tree_key_t k) {
-    avl_tree_node_t *n = malloc(sizeof(avl_tree_node_t) + t->node_data_size);
-
-    assert(n);
-
-    n->height = 1;
-    n->data = n + 1;
-    n->host = t;
-    n->key = k;
-    n->left = n->right = n->parent = NULL;
-
-    return n;
+static inline
+void node_dealloc(avl_tree_t *t, avl_tree_node_t *n) {
+    if (t->slab)
+        slab_free(t->slab, n);
+    else
+        allocator_free(t->allocator, n, node_size(t));
 }
 
 static inline
@@ -146,7 +126,7 @@ avl_tree_node_t *node_insert(avl_tree_node_t *n,
                              avl_tree_key_t k,
                              avl_tree_node_t **inserted) {
     if (!n) {
-        n = node_operators[t->inplace].allocator(t, k);
+        n = node_alloc(t, k);
         n->parent = parent;
         *inserted = n;
 
@@ -169,7 +149,7 @@ avl_tree_node_t *node_insert_or_get(avl_tree_node_t *n,
                                     avl_tree_node_t **inserted,
                                     bool *node_inserted) {
     if (!n) {
-        n = node_operators[t->inplace].allocator(t, k);
+        n = node_alloc(t, k);
         n->parent = parent;
         *inserted = n;
         *node_inserted = true;
@@ -248,7 +228,7 @@ avl_tree_node_t *node_remove(avl_tree_node_t *n, avl_tree_key_t k,
 
         copy = *n;
 
-        node_operators[n->host->inplace].deallocator(n);
+        node_dealloc(copy.host, n);
 
         if (!copy.right) {
             if (copy.left)
@@ -355,17 +335,46 @@ void node_purge(avl_tree_node_t *n) {
     if (n->right)
         node_purge(n->right);
 
-    node_operators[n->host->inplace].deallocator(n);
+    node_dealloc(n->host, n);
 }
 
 /**************** API ****************/
 void avl_tree_init(avl_tree_t *tree, bool inplace, size_t node_data_size) {
+    avl_tree_init_allocator(tree, inplace, node_data_size, NULL);
+}
+
+void avl_tree_init_allocator(avl_tree_t *tree, bool inplace,
+                             size_t node_data_size,
+                             const allocator_t *allocator) {
     assert(tree);
 
     tree->inplace = inplace;
     tree->node_data_size = node_data_size;
     tree->count = 0;
     tree->root = NULL;
+
+    tree->allocator = allocator ? allocator : &allocator_default;
+
+    tree->slab = NULL;
+    tree->slab_owned = false;
+}
+
+void avl_tree_init_slab(avl_tree_t *tree, bool inplace, size_t node_data_size,
+                        slab_cache_t *slab) {
+    avl_tree_init(tree, inplace, node_data_size);
+
+    if (slab) {
+        assert(slab->object_size >= node_size(tree));
+        tree->slab = slab;
+        return;
+    }
+
+    tree->slab = allocator_alloc(tree->allocator, sizeof(*tree->slab));
+    assert(tree->slab);
+
+    slab_cache_init_allocator(tree->slab, node_size(tree), 0,
+                              tree->allocator);
+    tree->slab_owned = true;
 }
 
 avl_tree_node_t *avl_tree_get(avl_tree_t *t, avl_tree_key_t k) {
@@ -463,9 +472,27 @@ avl_tree_node_t *avl_tree_node_max(avl_tree_node_t *n) {
 void avl_tree_purge(avl_tree_t *tree) {
     assert(tree);
 
-    if (tree->root)
+    if (tree->slab_owned)
+        /* every node goes with whole slabs at once */
+        slab_cache_reset(tree->slab);
+    else if (tree->root && (tree->slab || tree->allocator->free))
         node_purge(tree->root);
 
     tree->count = 0;
     tree->root = NULL;
 }
+
+void avl_tree_deinit(avl_tree_t *tree) {
+    assert(tree);
+
+    avl_tree_purge(tree);
+
+    if (!tree->slab_owned)
+        return;
+
+    slab_cache_deinit(tree->slab);
+    allocator_free(tree->allocator, tree->slab, sizeof(*tree->slab));
+
+    tree->slab = NULL;
+    tree->slab_owned = false;
+}
@@ -11,14 +11,45 @@
 
 typedef bool (*reallocer_func)(buffer_t *b, size_t newsize);
 
+/* inline storage is never reallocated, data is moved to heap instead */
+static
+void *buffer_resize(buffer_t *b, size_t rs) {
+    void *d;
+
+    if (!b->inline_storage)
+        return allocator_realloc(b->allocator, b->data, b->real_size, rs);
+
+    assert(rs > b->real_size);
+
+    d = allocator_alloc(b->allocator, rs);
+
+    if (d) {
+        memcpy(d, b->data, b->user_size);
+        b->inline_storage = false;
+    }
+
+    return d;
+}
+
 static
 bool realloc_shrinkable(buffer_t *b, size_t newsize) {
     void *d;
+    size_t rs;
     assert(b);
-    d = realloc(b->data, newsize);
+
+    /* never shrink below reserved size */
+    rs = newsize < b->reserved ? b->reserved : newsize;
+
+    if (rs == b->real_size) {
+        b->user_size = newsize;
+        return true;
+    }
+
+    d = buffer_resize(b, rs);
 
     if (d) {
-        b->user_size = b->real_size = newsize;
+        b->user_size = newsize;
+        b->real_size = rs;
         b->data = d;
     }
 
@@ -31,12 +62,12 @@ bool realloc_nonshrinkable(buffer_t *b, size_t newsize) {
 
     assert(b);
 
-    if (newsize < b->real_size) {
+    if (newsize <= b->real_size) {
         b->user_size = newsize;
         return true;
     }
 
-    d = realloc(b->data, newsize);
+    d = buffer_resize(b, newsize);
 
     if (d) {
         b->user_size = newsize;
@@ -56,8 +87,8 @@ bool realloc_economic(buffer_t *b, size_t newsize) {
     size_t rs;
     void *d;
 
-    if (newsize < b->real_size / 4)
-        rs = lesser;
+    if (newsize < b->real_size / 4 && b->reserved < b->real_size)
+        rs = lesser < b->reserved ? b->reserved : lesser;
     else if (newsize > b->real_size) {
         if (newsize < greater)
             rs = greater;
@@ -69,7 +100,7 @@ bool realloc_economic(buffer_t *b, size_t newsize) {
         return true;
     }
 
-    d = realloc(b->data, rs);
+    d = buffer_resize(b, rs);
 
     if (d) {
         b->user_size = newsize;
@@ -88,11 +119,32 @@ static const reallocer_func reallocer[buffer_policy_max] = {
 
 /***************************** BUFFER *****************************/
 void buffer_init(buffer_t *b, size_t size, enum buffer_policy pol) {
+    buffer_init_allocator(b, size, pol, NULL);
+}
+
+void buffer_init_allocator(buffer_t *b, size_t size, enum buffer_policy pol,
+                           const allocator_t *allocator) {
     assert(b && pol < buffer_policy_max);
 
     b->pol = pol;
+    b->allocator = allocator ? allocator : &allocator_default;
     b->real_size = b->user_size = size;
-    b->data = malloc(b->user_size);
+    b->reserved = 0;
+    b->inline_storage = false;
+    b->data = allocator_alloc(b->allocator, b->user_size);
+}
+
+void buffer_init_inline(buffer_t *b, void *storage, size_t storage_size,
+                        enum buffer_policy pol) {
+    assert(b && storage && pol < buffer_policy_max);
+
+    b->pol = pol;
+    b->allocator = &allocator_default;
+    b->user_size = 0;
+    /* storage is kept whatever the policy is */
+    b->real_size = b->reserved = storage_size;
+    b->inline_storage = true;
+    b->data = storage;
 }
 
 bool buffer_realloc(buffer_t *b, size_t newsize) {
@@ -100,21 +152,94 @@ bool buffer_realloc(buffer_t *b, size_t newsize) {
     return reallocer[b->pol](b, newsize);
 }
 
+bool buffer_reserve(buffer_t *b, size_t size) {
+    void *d;
+
+    assert(b);
+
+    if (size > b->real_size) {
+        d = buffer_resize(b, size);
+
+        if (!d)
+            return false;
+
+        b->data = d;
+        b->real_size = size;
+    }
+
+    if (size > b->reserved)
+        b->reserved = size;
+
+    return true;
+}
+
+bool buffer_shrink_to_fit(buffer_t *b) {
+    void *d;
+
+    assert(b);
+
+    if (b->inline_storage)
+        return true;
+
+    b->reserved = 0;
+
+    if (b->real_size == b->user_size)
+        return true;
+
+    /* realloc to zero size may either free or not */
+    if (!b->user_size) {
+        allocator_free(b->allocator, b->data, b->real_size);
+        b->data = NULL;
+        b->real_size = 0;
+        return true;
+    }
+
+    d = allocator_realloc(b->allocator, b->data, b->real_size, b->user_size);
+
+    if (!d)
+        return false;
+
+    b->data = d;
+    b->real_size = b->user_size;
+
+    return true;
+}
+
 void buffer_deinit(buffer_t *b) {
     assert(b);
 
-    if (b->data)
-        free(b->data);
+    if (b->data && !b->inline_storage)
+        allocator_free(b->allocator, b->data, b->real_size);
 
     b->user_size = b->real_size = 0;
 }
 
 /***************************** VECTOR *****************************/
+/* external definitions of accessors inlined from header */
+extern inline void *vector_begin(vector_t *v);
+extern inline void *vector_end(vector_t *v);
+extern inline void *vector_get(vector_t *v, size_t idx);
+extern inline void *vector_next(vector_t *v, void *d);
+extern inline void *vector_prev(vector_t *v, void *d);
+
 void vector_init(vector_t *v, size_t size, size_t count) {
+    vector_init_allocator(v, size, count, NULL);
+}
+
+void vector_init_allocator(vector_t *v, size_t size, size_t count,
+                           const allocator_t *allocator) {
     assert(v);
     v->element_size = size;
     v->count = count;
-    buffer_init(&v->data, size * count, bp_economic);
+    buffer_init_allocator(&v->data, size * count, bp_economic, allocator);
+}
+
+void vector_init_inline(vector_t *v, size_t size,
+                        void *storage, size_t capacity) {
+    assert(v && size);
+    v->element_size = size;
+    v->count = 0;
+    buffer_init_inline(&v->data, storage, size * capacity, bp_economic);
 }
 
 void vector_remove(vector_t *v, size_t idx) {
@@ -167,28 +292,7 @@ void vector_remove_range(vector_t *v, size_t from, size_t count) {
 }
 
 void *vector_insert(vector_t *v, size_t idx) {
-    size_t shifting;
-    void *newelement;
-    void *newpos;
-    bool realloced;
-
-    assert(v);
-    assert(idx <= v->count);
-
-    newelement = v->data.data + v->element_size * idx;
-    newpos = newelement + v->element_size;
-    shifting = v->element_size * (v->count - idx);
-
-    ++v->count;
-
-    realloced = buffer_realloc(&v->data, v->element_size * (v->count + 1));
-
-    assert(realloced);
-    DONT_USE(realloced);
-
-    memmove(newpos, newelement, shifting);
-
-    return newelement;
+    return vector_insert_n(v, idx, NULL, 1);
 }
 
 void *vector_append(vector_t *v) {
@@ -229,39 +333,171 @@ void *vector_prepend(vector_t *v) {
     return d;
 }
 
-void *vector_begin(vector_t *v) {
+void vector_swap_remove(vector_t *v, size_t idx) {
+    char *hole;
+
     assert(v);
-    return v->data.data;
+    assert(v->count > idx);
+
+    --v->count;
+
+    hole = v->data.data + idx * v->element_size;
+
+    if (idx != v->count)
+        memcpy(hole, v->data.data + v->count * v->element_size,
+               v->element_size);
+
+    /* memory is kept for elements to come */
+    v->data.user_size = v->count * v->element_size;
+}
+
+bool vector_pop_back(vector_t *v, void *el) {
+    assert(v);
+
+    if (!v->count)
+        return false;
+
+    --v->count;
+
+    if (el)
+        memcpy(el, v->data.data + v->count * v->element_size,
+               v->element_size);
+
+    v->data.user_size = v->count * v->element_size;
+
+    return true;
 }
 
-void *vector_end(vector_t *v) {
+void *vector_append_n(vector_t *v, const void *src, size_t count) {
+    size_t filled;
+    void *d;
+    bool realloced;
+
     assert(v);
-    return v->data.data + v->count * v->element_size;
+
+    filled = v->element_size * v->count;
+
+    realloced = buffer_realloc(&v->data, filled + v->element_size * count);
+    assert(realloced);
+    DONT_USE(realloced);
+
+    d = v->data.data + filled;
+    v->count += count;
+
+    if (src)
+        memcpy(d, src, v->element_size * count);
+
+    return d;
 }
 
-void *vector_get(vector_t *v, size_t idx) {
+void *vector_insert_n(vector_t *v, size_t idx, const void *src, size_t count) {
+    size_t shifting;
+    void *newelement;
+    bool realloced;
+
+    assert(v);
+    assert(idx <= v->count);
+
+    shifting = v->element_size * (v->count - idx);
+
+    v->count += count;
+
+    realloced = buffer_realloc(&v->data, v->element_size * v->count);
+    assert(realloced);
+    DONT_USE(realloced);
+
+    /* data may have moved on reallocation */
+    newelement = v->data.data + v->element_size * idx;
+
+    memmove(newelement + v->element_size * count, newelement, shifting);
+
+    if (src)
+        memcpy(newelement, src, v->element_size * count);
+
+    return newelement;
+}
+
+void vector_assign(vector_t *v, const void *src, size_t count) {
+    bool realloced;
+
+    assert(v);
+
+    realloced = buffer_realloc(&v->data, v->element_size * count);
+    assert(realloced);
+    DONT_USE(realloced);
+
+    v->count = count;
+
+    if (src)
+        memcpy(v->data.data, src, v->element_size * count);
+}
+
+size_t vector_remove_if(vector_t *v, vector_predicate_t pred, void *ctx) {
+    char *rd, *wr, *end;
+    size_t removed;
+    bool realloced;
+
+    assert(v && pred);
+
+    end = v->data.data + v->element_size * v->count;
+
+    /* kept elements are compacted towards the beginning */
+    for (rd = wr = v->data.data; rd < end; rd += v->element_size) {
+        if (pred(rd, ctx))
+            continue;
+
+        if (wr != rd)
+            memcpy(wr, rd, v->element_size);
+
+        wr += v->element_size;
+    }
+
+    removed = (end - wr) / v->element_size;
+
+    if (!removed)
+        return 0;
+
+    v->count -= removed;
+
+    realloced = buffer_realloc(&v->data, v->element_size * v->count);
+    assert(realloced);
+    DONT_USE(realloced);
+
+    return removed;
+}
+
+size_t vector_capacity(const vector_t *v) {
+    assert(v && v->element_size);
+    return v->data.real_size / v->element_size;
+}
+
+void vector_reserve(vector_t *v, size_t count) {
+    bool reserved;
+
     assert(v);
-    assert(v->count > idx);
 
-    return v->data.data + idx * v->element_size;
+    reserved = buffer_reserve(&v->data, count * v->element_size);
+    assert(reserved);
+    DONT_USE(reserved);
 }
 
-void *vector_next(vector_t *v, void *d) {
+void vector_shrink_to_fit(vector_t *v) {
+    bool shrunk;
+
     assert(v);
-    assert(!(d < v->data.data));
-    assert(d < v->data.data + v->count * v->element_size);
-    assert((d - v->data.data) % v->element_size == 0);
 
-    return d + v->element_size;
+    shrunk = buffer_shrink_to_fit(&v->data);
+    assert(shrunk);
+    DONT_USE(shrunk);
 }
 
-void *vector_prev(vector_t *v, void *d) {
+void vector_clear(vector_t *v) {
     assert(v);
-    assert(!(d < v->data.data));
-    assert(d < v->data.data + v->count * v->element_size);
-    assert((d - v->data.data) % v->element_size == 0);
 
-    return d == v->data.data ? d : d - v->element_size;
+    /* keep the memory for elements to come */
+    v->data.reserved = v->data.real_size;
+    v->data.user_size = 0;
+    v->count = 0;
 }
 
 void vector_deinit(vector_t *v) {
@@ -271,49 +507,186 @@ void vector_deinit(vector_t *v) {
     v->element_size = 0;
 }
 
-/***************************** LIST *****************************/
-typedef list_element_t *(*list_el_allocator)(list_t *l);
-typedef void (*list_el_deallocator)(list_element_t *el);
+/***************************** DEQUE *****************************/
+#define DEQUE_MIN_CAPACITY  8
+
+static inline
+void *deque_at(deque_t *d, size_t idx) {
+    return d->data.data +
+           ((d->head + idx) & (d->capacity - 1)) * d->element_size;
+}
 
 static
-list_element_t *alloc_lel_inplace(list_t *l) {
-    list_element_t *le = malloc(sizeof(list_element_t) + l->element_size);
+void deque_grow(deque_t *d) {
+    size_t old_capacity = d->capacity;
+    size_t wrapped;
+    bool realloced;
 
-    assert(le);
+    d->capacity = old_capacity ? old_capacity * 2 : DEQUE_MIN_CAPACITY;
 
-    le->data = le + 1;
-    le->host = l;
-    le->next = le->prev = NULL;
-    return le;
+    realloced = buffer_realloc(&d->data, d->capacity * d->element_size);
+    assert(realloced);
+    DONT_USE(realloced);
+
+    if (d->head + d->count <= old_capacity)
+        return;
+
+    /* unwrap: move elements from the ring's start right after old end */
+    wrapped = d->head + d->count - old_capacity;
+    memcpy(d->data.data + old_capacity * d->element_size,
+           d->data.data,
+           wrapped * d->element_size);
+}
+
+void deque_init(deque_t *d, size_t size, size_t capacity) {
+    deque_init_allocator(d, size, capacity, NULL);
+}
+
+void deque_init_allocator(deque_t *d, size_t size, size_t capacity,
+                          const allocator_t *allocator) {
+    size_t cap = capacity ? DEQUE_MIN_CAPACITY : 0;
+
+    assert(d && size);
+
+    while (cap < capacity)
+        cap *= 2;
+
+    d->element_size = size;
+    d->capacity = cap;
+    d->head = 0;
+    d->count = 0;
+
+    buffer_init_allocator(&d->data, cap * size, bp_non_shrinkable, allocator);
+}
+
+void deque_deinit(deque_t *d) {
+    assert(d);
+
+    buffer_deinit(&d->data);
+    d->capacity = d->count = d->head = 0;
+}
+
+size_t deque_size(const deque_t *d) {
+    assert(d);
+    return d->count;
+}
+
+void deque_clear(deque_t *d) {
+    assert(d);
+    d->head = d->count = 0;
+}
+
+void *deque_push_back(deque_t *d) {
+    assert(d);
+
+    if (d->count == d->capacity)
+        deque_grow(d);
+
+    return deque_at(d, d->count++);
+}
+
+void *deque_push_front(deque_t *d) {
+    assert(d);
+
+    if (d->count == d->capacity)
+        deque_grow(d);
+
+    d->head = (d->head - 1) & (d->capacity - 1);
+    ++d->count;
+
+    return deque_at(d, 0);
+}
+
+bool deque_pop_back(deque_t *d, void *el) {
+    assert(d);
+
+    if (!d->count)
+        return false;
+
+    --d->count;
+
+    if (el)
+        memcpy(el, deque_at(d, d->count), d->element_size);
+
+    return true;
+}
+
+bool deque_pop_front(deque_t *d, void *el) {
+    assert(d);
+
+    if (!d->count)
+        return false;
+
+    if (el)
+        memcpy(el, deque_at(d, 0), d->element_size);
+
+    d->head = (d->head + 1) & (d->capacity - 1);
+    --d->count;
+
+    return true;
+}
+
+void *deque_get(deque_t *d, size_t idx) {
+    assert(d);
+    assert(idx < d->count);
+
+    return deque_at(d, idx);
+}
+
+void *deque_front(deque_t *d) {
+    assert(d);
+    return d->count ? deque_at(d, 0) : NULL;
+}
+
+void *deque_back(deque_t *d) {
+    assert(d);
+    return d->count ? deque_at(d, d->count - 1) : NULL;
+}
+
+/***************************** LIST *****************************/
+/* external definitions of accessors inlined from header */
+extern inline size_t list_size(const list_t *l);
+extern inline list_element_t *list_begin(list_t *l);
+extern inline list_element_t *list_end(list_t *l);
+extern inline list_element_t *list_next(list_t *l, list_element_t *el);
+extern inline list_element_t *list_prev(list_t *l, list_element_t *el);
+
+static inline
+size_t lel_size(const list_t *l) {
+    return sizeof(list_element_t) + (l->inplace ? l->element_size : 0);
 }
 
 static
-list_element_t *alloc_lel_simple(list_t *l) {
-    list_element_t *le = malloc(sizeof(list_element_t));
+list_element_t *lel_alloc(list_t *l) {
+    list_element_t *le;
+
+    if (l->slab)
+        le = slab_alloc(l->slab);
+    else
+        le = allocator_alloc(l->allocator, lel_size(l));
 
     assert(le);
 
-    le->data = NULL;
+    le->data = l->inplace ? le + 1 : NULL;
     le->host = l;
     le->next = le->prev = NULL;
     return le;
 }
 
-static const struct {
-    list_el_allocator   allocator;
-    list_el_deallocator deallocator;
-} list_el_alloc_dealloc[2] = {
-    [true]  = {
-        .allocator      = alloc_lel_inplace,
-        .deallocator    = (list_el_deallocator)free
-    },
-    [false] = {
-        .allocator      = alloc_lel_simple,
-        .deallocator    = (list_el_deallocator)free
-    }
-};
+static inline
+void lel_dealloc(list_t *l, list_element_t *el) {
+    if (l->slab)
+        slab_free(l->slab, el);
+    else
+        allocator_free(l->allocator, el, lel_size(l));
+}
 
 void list_init(list_t *l, bool inplace, size_t size) {
+    list_init_allocator(l, inplace, size, NULL);
+}
+
+void list_init_allocator(list_t *l, bool inplace, size_t size,
+                         const allocator_t *allocator) {
     assert(l);
     assert(!inplace || (inplace && size));
 
@@ -323,11 +696,27 @@ void list_init(list_t *l, bool inplace, size_t size) {
     l->inplace = inplace;
 
     l->count = 0;
+
+    l->allocator = allocator ? allocator : &allocator_default;
+
+    l->slab = NULL;
+    l->slab_owned = false;
 }
 
-size_t list_size(const list_t *l) {
-    assert(l);
-    return l->count;
+void list_init_slab(list_t *l, bool inplace, size_t size, slab_cache_t *slab) {
+    list_init(l, inplace, size);
+
+    if (slab) {
+        assert(slab->object_size >= lel_size(l));
+        l->slab = slab;
+        return;
+    }
+
+    l->slab = allocator_alloc(l->allocator, sizeof(*l->slab));
+    assert(l->slab);
+
+    slab_cache_init_allocator(l->slab, lel_size(l), 0, l->allocator);
+    l->slab_owned = true;
 }
 
 list_element_t *list_prepend(list_t *l) {
@@ -335,7 +724,7 @@ list_element_t *list_prepend(list_t *l) {
 
     assert(l);
 
-    el = list_el_alloc_dealloc[l->inplace].allocator(l);
+    el = lel_alloc(l);
 
     el->prev = NULL;
     el->next = l->front;
@@ -356,7 +745,7 @@ list_element_t *list_append(list_t *l) {
 
     assert(l);
 
-    el = list_el_alloc_dealloc[l->inplace].allocator(l);
+    el = lel_alloc(l);
 
     el->prev = l->back;
     el->next = NULL;
@@ -381,7 +770,7 @@ list_element_t *list_add_after(list_t *l, list_element_t *el) {
     if (!el)
         return list_prepend(l);
 
-    newel = list_el_alloc_dealloc[l->inplace].allocator(l);
+    newel = lel_alloc(l);
 
     newel->prev = el;
 
@@ -413,7 +802,7 @@ list_element_t *list_add_before(list_t *l, list_element_t *el) {
     if (!el)
         return list_append(l);
 
-    newel = list_el_alloc_dealloc[l->inplace].allocator(l);
+    newel = lel_alloc(l);
 
     newel->next = el;
 
@@ -447,7 +836,7 @@ list_element_t *list_remove_and_advance(list_t *l, list_element_t *el) {
     if (el) {
         prev = el->prev;
         next = el->next;
-        list_el_alloc_dealloc[l->inplace].deallocator(el);
+        lel_dealloc(l, el);
     }
 
     if (prev)
@@ -472,6 +861,15 @@ void list_purge(list_t *l) {
 
     assert(l);
 
+    if (l->slab_owned) {
+        /* every element goes with whole slabs at once */
+        slab_cache_reset(l->slab);
+        l->count = 0;
+    }
+    else if (!l->slab && !l->allocator->free)
+        /* memory goes back in bulk with allocator */
+        l->count = 0;
+
     if (!l->count) {
         l->front = NULL;
         l->back = NULL;
@@ -480,7 +878,7 @@ void list_purge(list_t *l) {
 
     for (el = l->front; el; el = el2) {
         el2 = el->next;
-        list_el_alloc_dealloc[l->inplace].deallocator(el);
+        lel_dealloc(l, el);
     }
 
     l->front = NULL;
@@ -489,32 +887,167 @@ void list_purge(list_t *l) {
     l->count = 0;
 }
 
-list_element_t *list_begin(list_t *l) {
+void list_deinit(list_t *l) {
     assert(l);
-    return l->front;
+
+    list_purge(l);
+
+    if (!l->slab_owned)
+        return;
+
+    slab_cache_deinit(l->slab);
+    allocator_free(l->allocator, l->slab, sizeof(*l->slab));
+
+    l->slab = NULL;
+    l->slab_owned = false;
 }
 
-list_element_t *list_end(list_t *l) {
+/***************************** INTRUSIVE LIST *****************************/
+static inline
+void ilist_link_between(ilist_link_t *link,
+                        ilist_link_t *prev, ilist_link_t *next) {
+    link->prev = prev;
+    link->next = next;
+    prev->next = link;
+    next->prev = link;
+}
+
+void ilist_init(ilist_t *l) {
     assert(l);
-    return l->back;
+
+    l->head.prev = l->head.next = &l->head;
+    l->count = 0;
 }
 
-list_element_t *list_next(list_t *l, list_element_t *el) {
-    list_element_t *next;
+size_t ilist_size(const ilist_t *l) {
     assert(l);
-    assert(!el || el->host == l);
 
-    next = (!el
-            ? l->front : el->next);
-    return next;
+    return l->count;
 }
 
-list_element_t *list_prev(list_t *l, list_element_t *el) {
-    list_element_t *prev;
+bool ilist_empty(const ilist_t *l) {
     assert(l);
-    assert(!el || el->host == l);
 
-    prev = (!el
-            ? l->back : el->prev);
-    return prev;
+    return !l->count;
+}
+
+void ilist_link_init(ilist_link_t *link) {
+    assert(link);
+
+    link->prev = link->next = NULL;
+}
+
+bool ilist_linked(const ilist_link_t *link) {
+    assert(link);
+
+    return !!link->next;
+}
+
+void ilist_push_front(ilist_t *l, ilist_link_t *link) {
+    assert(l && link);
+
+    ilist_link_between(link, &l->head, l->head.next);
+    ++l->count;
+}
+
+void ilist_push_back(ilist_t *l, ilist_link_t *link) {
+    assert(l && link);
+
+    ilist_link_between(link, l->head.prev, &l->head);
+    ++l->count;
+}
+
+void ilist_insert_after(ilist_t *l, ilist_link_t *pos, ilist_link_t *link) {
+    assert(l && link);
+
+    if (!pos)
+        pos = &l->head;
+
+    ilist_link_between(link, pos, pos->next);
+    ++l->count;
+}
+
+void ilist_insert_before(ilist_t *l, ilist_link_t *pos, ilist_link_t *link) {
+    assert(l && link);
+
+    if (!pos)
+        pos = &l->head;
+
+    ilist_link_between(link, pos->prev, pos);
+    ++l->count;
+}
+
+void ilist_remove(ilist_t *l, ilist_link_t *link) {
+    assert(l && link && l->count);
+    assert(link != &l->head && link->next && link->prev);
+
+    link->prev->next = link->next;
+    link->next->prev = link->prev;
+
+    link->prev = link->next = NULL;
+    --l->count;
+}
+
+ilist_link_t *ilist_pop_front(ilist_t *l) {
+    ilist_link_t *link = ilist_front(l);
+
+    if (link)
+        ilist_remove(l, link);
+
+    return link;
+}
+
+ilist_link_t *ilist_pop_back(ilist_t *l) {
+    ilist_link_t *link = ilist_back(l);
+
+    if (link)
+        ilist_remove(l, link);
+
+    return link;
+}
+
+void ilist_splice(ilist_t *to, ilist_t *from) {
+    ilist_link_t *first, *last;
+
+    assert(to && from && to != from);
+
+    if (!from->count)
+        return;
+
+    first = from->head.next;
+    last = from->head.prev;
+
+    first->prev = to->head.prev;
+    to->head.prev->next = first;
+
+    last->next = &to->head;
+    to->head.prev = last;
+
+    to->count += from->count;
+
+    ilist_init(from);
+}
+
+ilist_link_t *ilist_front(ilist_t *l) {
+    assert(l);
+
+    return l->count ? l->head.next : NULL;
+}
+
+ilist_link_t *ilist_back(ilist_t *l) {
+    assert(l);
+
+    return l->count ? l->head.prev : NULL;
+}
+
+ilist_link_t *ilist_next(ilist_t *l, ilist_link_t *link) {
+    assert(l && link);
+
+    return link->next == &l->head ? NULL : link->next;
+}
+
+ilist_link_t *ilist_prev(ilist_t *l, ilist_link_t *link) {
+    assert(l && link);
+
+    return link->prev == &l->head ? NULL : link->prev;
 }
@@ -0,0 +1,299 @@
+#include "coroutine-channel.h"
+#include "coroutine-scheduler.h"
+#include "containers.h"
+#include "common.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <pthread.h>
+#include <assert.h>
+
+#define UNBOUNDED_INITIAL_CAPACITY  16
+
+enum {
+    CHANNEL_FAILED = 0,
+    CHANNEL_OK = 1
+};
+
+/******************************* internal funcs *******************************/
+static inline
+void *ring_at(coroutine_channel_t *ch, size_t idx) {
+    return (char *)ch->ring.data +
+           ((ch->head + idx) % ch->capacity) * ch->element_size;
+}
+
+static
+void ring_grow(coroutine_channel_t *ch) {
+    size_t old_capacity = ch->capacity;
+    size_t wrapped;
+    bool realloced;
+
+    ch->capacity = old_capacity ? old_capacity * 2 : UNBOUNDED_INITIAL_CAPACITY;
+
+    realloced = buffer_realloc(&ch->ring, ch->capacity * ch->element_size);
+    assert(realloced);
+    DONT_USE(realloced);
+
+    if (ch->head + ch->count <= old_capacity)
+        return;
+
+    /* unwrap: move elements from the ring's start right after old end */
+    wrapped = ch->head + ch->count - old_capacity;
+    memcpy((char *)ch->ring.data + old_capacity * ch->element_size,
+           ch->ring.data,
+           wrapped * ch->element_size);
+}
+
+static inline
+void ring_push_back(coroutine_channel_t *ch, const void *el) {
+    memcpy(ring_at(ch, ch->count), el, ch->element_size);
+    ++ch->count;
+}
+
+static inline
+void ring_pop_front(coroutine_channel_t *ch, void *el) {
+    memcpy(el, ring_at(ch, 0), ch->element_size);
+    ch->head = (ch->head + 1) % ch->capacity;
+    --ch->count;
+}
+
+static
+void channel_init(coroutine_channel_t *ch, size_t element_size,
+                  size_t capacity, bool bounded) {
+    int rc;
+
+    assert(ch && element_size);
+
+    rc = pthread_mutex_init(&ch->mtx, NULL);
+    assert(0 == rc);
+    DONT_USE(rc);
+
+    buffer_init(&ch->ring, element_size * capacity, bp_non_shrinkable);
+
+    ch->element_size = element_size;
+    ch->capacity = capacity;
+    ch->head = 0;
+    ch->count = 0;
+    ch->bounded = bounded;
+    ch->closed = false;
+
+    coroutine_wait_queue_init(&ch->senders);
+    coroutine_wait_queue_init(&ch->receivers);
+}
+
+/* should be called with ch->mtx locked,
+ * waiter to wake after unlocking is returned in \c *wake
+ */
+static
+bool channel_try_send_locked(coroutine_channel_t *ch, const void *el,
+                             coroutine_waiter_t **wake) {
+    coroutine_waiter_t *w;
+
+    *wake = NULL;
+
+    /* receivers wait only while nothing is buffered */
+    if ((w = coroutine_wait_queue_pop(&ch->receivers))) {
+        memcpy(w->data, el, ch->element_size);
+        *wake = w;
+        return true;
+    }
+
+    if (!ch->bounded && ch->count == ch->capacity)
+        ring_grow(ch);
+
+    if (ch->count < ch->capacity) {
+        ring_push_back(ch, el);
+        return true;
+    }
+
+    return false;
+}
+
+/* should be called with ch->mtx locked */
+static
+bool channel_try_recv_locked(coroutine_channel_t *ch, void *el,
+                             coroutine_waiter_t **wake) {
+    coroutine_waiter_t *w;
+
+    *wake = NULL;
+
+    if (ch->count) {
+        ring_pop_front(ch, el);
+
+        /* room for the longest waiting sender */
+        if ((w = coroutine_wait_queue_pop(&ch->senders))) {
+            ring_push_back(ch, w->data);
+            *wake = w;
+        }
+
+        return true;
+    }
+
+    /* unbuffered channel, take directly from sender */
+    if ((w = coroutine_wait_queue_pop(&ch->senders))) {
+        memcpy(el, w->data, ch->element_size);
+        *wake = w;
+        return true;
+    }
+
+    return false;
+}
+
+/******************************* API *******************************/
+void coroutine_channel_init(coroutine_channel_t *ch,
+                            size_t element_size, size_t capacity) {
+    channel_init(ch, element_size, capacity, true);
+}
+
+void coroutine_channel_init_unbounded(coroutine_channel_t *ch,
+                                      size_t element_size) {
+    channel_init(ch, element_size, 0, false);
+}
+
+void coroutine_channel_deinit(coroutine_channel_t *ch) {
+    assert(ch);
+    assert(coroutine_wait_queue_empty(&ch->senders));
+    assert(coroutine_wait_queue_empty(&ch->receivers));
+
+    buffer_deinit(&ch->ring);
+    ch->capacity = ch->count = ch->head = 0;
+
+    pthread_mutex_destroy(&ch->mtx);
+}
+
+void coroutine_channel_close(coroutine_channel_t *ch) {
+    coroutine_wait_queue_t senders, receivers;
+    coroutine_waiter_t *w;
+
+    assert(ch);
+
+    pthread_mutex_lock(&ch->mtx);
+
+    ch->closed = true;
+
+    senders = ch->senders;
+    receivers = ch->receivers;
+
+    coroutine_wait_queue_init(&ch->senders);
+    coroutine_wait_queue_init(&ch->receivers);
+
+    pthread_mutex_unlock(&ch->mtx);
+
+    while ((w = coroutine_wait_queue_pop(&senders)))
+        coroutine_waiter_wake(w, CHANNEL_FAILED);
+
+    while ((w = coroutine_wait_queue_pop(&receivers)))
+        coroutine_waiter_wake(w, CHANNEL_FAILED);
+}
+
+bool coroutine_channel_send(coroutine_channel_t *ch, coroutine_t *cr,
+                            const void *el) {
+    coroutine_waiter_t *wake;
+    coroutine_waiter_t w;
+
+    assert(ch && cr && el);
+
+    pthread_mutex_lock(&ch->mtx);
+
+    if (ch->closed) {
+        pthread_mutex_unlock(&ch->mtx);
+        return false;
+    }
+
+    if (channel_try_send_locked(ch, el, &wake)) {
+        pthread_mutex_unlock(&ch->mtx);
+
+        if (wake)
+            coroutine_waiter_wake(wake, CHANNEL_OK);
+
+        return true;
+    }
+
+    /* receiver copies directly from el */
+    coroutine_waiter_init(&w, cr, (void *)el);
+    coroutine_wait_queue_push(&ch->senders, &w);
+
+    pthread_mutex_unlock(&ch->mtx);
+
+    return CHANNEL_OK == coroutine_waiter_wait(&w);
+}
+
+bool coroutine_channel_recv(coroutine_channel_t *ch, coroutine_t *cr,
+                            void *el) {
+    coroutine_waiter_t *wake;
+    coroutine_waiter_t w;
+
+    assert(ch && cr && el);
+
+    pthread_mutex_lock(&ch->mtx);
+
+    if (channel_try_recv_locked(ch, el, &wake)) {
+        pthread_mutex_unlock(&ch->mtx);
+
+        if (wake)
+            coroutine_waiter_wake(wake, CHANNEL_OK);
+
+        return true;
+    }
+
+    if (ch->closed) {
+        pthread_mutex_unlock(&ch->mtx);
+        return false;
+    }
+
+    /* sender copies directly to el */
+    coroutine_waiter_init(&w, cr, el);
+    coroutine_wait_queue_push(&ch->receivers, &w);
+
+    pthread_mutex_unlock(&ch->mtx);
+
+    return CHANNEL_OK == coroutine_waiter_wait(&w);
+}
+
+bool coroutine_channel_try_send(coroutine_channel_t *ch, const void *el) {
+    coroutine_waiter_t *wake = NULL;
+    bool sent = false;
+
+    assert(ch && el);
+
+    pthread_mutex_lock(&ch->mtx);
+
+    if (!ch->closed)
+        sent = channel_try_send_locked(ch, el, &wake);
+
+    pthread_mutex_unlock(&ch->mtx);
+
+    if (wake)
+        coroutine_waiter_wake(wake, CHANNEL_OK);
+
+    return sent;
+}
+
+bool coroutine_channel_try_recv(coroutine_channel_t *ch, void *el) {
+    coroutine_waiter_t *wake;
+    bool received;
+
+    assert(ch && el);
+
+    pthread_mutex_lock(&ch->mtx);
+    received = channel_try_recv_locked(ch, el, &wake);
+    pthread_mutex_unlock(&ch->mtx);
+
+    if (wake)
+        coroutine_waiter_wake(wake, CHANNEL_OK);
+
+    return received;
+}
+
+size_t coroutine_channel_size(coroutine_channel_t *ch) {
+    size_t count;
+
+    assert(ch);
+
+    pthread_mutex_lock(&ch->mtx);
+    count = ch->count;
+    pthread_mutex_unlock(&ch->mtx);
+
+    return count;
+}
@@ -0,0 +1,940 @@
+#include "coroutine-scheduler.h"
+#include "coroutine.h"
+#include "containers.h"
+#include "common.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <assert.h>
+
+#define DEQUE_INITIAL_SIZE          64
+/* injection queue is checked first every that many rounds */
+#define INJECTED_CHECK_INTERVAL     61
+
+static __thread coroutine_worker_t *current_worker = NULL;
+
+/***************************** DEQUE *****************************/
+/* Lê, Pop, Cohen, Zappa Nardelli.
+ * Correct and Efficient Work-Stealing for Weak Memory Models. PPoPP'13
+ */
+static
+coroutine_deque_array_t *ws_deque_array_alloc(size_t size) {
+    coroutine_deque_array_t *a;
+
+    a = malloc(sizeof(*a) + size * sizeof(a->buf[0]));
+    assert(a);
+
+    a->size = size;
+    a->retired = NULL;
+
+    return a;
+}
+
+static
+void ws_deque_init(coroutine_deque_t *d) {
+    atomic_init(&d->top, 0);
+    atomic_init(&d->bottom, 0);
+    atomic_init(&d->array, ws_deque_array_alloc(DEQUE_INITIAL_SIZE));
+}
+
+static
+void ws_deque_deinit(coroutine_deque_t *d) {
+    coroutine_deque_array_t *a, *retired;
+
+    for (a = atomic_load_explicit(&d->array, memory_order_relaxed); a;
+         a = retired) {
+        retired = a->retired;
+        free(a);
+    }
+}
+
+static
+coroutine_deque_array_t *ws_deque_grow(coroutine_deque_t *d,
+                                    coroutine_deque_array_t *a,
+                                    int64_t top, int64_t bottom) {
+    coroutine_deque_array_t *na = ws_deque_array_alloc(a->size * 2);
+    int64_t i;
+
+    for (i = top; i < bottom; ++i)
+        atomic_store_explicit(
+            &na->buf[i & (na->size - 1)],
+            atomic_load_explicit(&a->buf[i & (a->size - 1)],
+                                 memory_order_relaxed),
+            memory_order_relaxed);
+
+    /* thieves may still read the old array */
+    na->retired = a;
+    atomic_store_explicit(&d->array, na, memory_order_release);
+
+    return na;
+}
+
+/* owner only */
+static
+void ws_deque_push(coroutine_deque_t *d, coroutine_t *cr) {
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    coroutine_deque_array_t *a = atomic_load_explicit(&d->array,
+                                                      memory_order_relaxed);
+
+    if (b - t > (int64_t)a->size - 1)
+        a = ws_deque_grow(d, a, t, b);
+
+    atomic_store_explicit(&a->buf[b & (a->size - 1)], cr,
+                          memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+}
+
+/* owner only */
+static
+coroutine_t *ws_deque_take(coroutine_deque_t *d) {
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    coroutine_deque_array_t *a = atomic_load_explicit(&d->array,
+                                                      memory_order_relaxed);
+    int64_t t;
+    coroutine_t *cr = NULL;
+
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    t = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+    if (t > b) {
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    cr = atomic_load_explicit(&a->buf[b & (a->size - 1)],
+                              memory_order_relaxed);
+
+    if (t == b) {
+        /* the last one, race against thieves */
+        if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                     memory_order_seq_cst,
+                                                     memory_order_relaxed))
+            cr = NULL;
+
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    }
+
+    return cr;
+}
+
+/* any thread,
+ * \c *retry is set when lost the race and the deque might be non-empty
+ */
+static
+coroutine_t *ws_deque_steal(coroutine_deque_t *d, bool *retry) {
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    int64_t b;
+    coroutine_deque_array_t *a;
+    coroutine_t *cr;
+
+    atomic_thread_fence(memory_order_seq_cst);
+    b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+
+    if (t >= b)
+        return NULL;
+
+    a = atomic_load_explicit(&d->array, memory_order_acquire);
+    cr = atomic_load_explicit(&a->buf[t & (a->size - 1)],
+                              memory_order_relaxed);
+
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed)) {
+        *retry = true;
+        return NULL;
+    }
+
+    return cr;
+}
+
+static inline
+bool ws_deque_empty(coroutine_deque_t *d) {
+    return atomic_load(&d->bottom) <= atomic_load(&d->top);
+}
+
+/***************************** TIMERS *****************************/
+/* Binary min-heap of coroutine_timer_t kept in s->timers.
+ * Each coroutine tracks its entry index so that a timer is disarmed
+ * in place. Should be called with s->mtx locked.
+ */
+static inline
+coroutine_timer_t *timer_at(coroutine_scheduler_t *s, size_t idx) {
+    return (coroutine_timer_t *)s->timers.data.data + idx;
+}
+
+static inline
+void timer_place(coroutine_scheduler_t *s, size_t idx,
+                 const coroutine_timer_t *t) {
+    *timer_at(s, idx) = *t;
+    t->cr->timer_idx = idx;
+}
+
+static
+void timer_sift_up(coroutine_scheduler_t *s, size_t idx) {
+    coroutine_timer_t t = *timer_at(s, idx);
+    size_t parent;
+
+    while (idx) {
+        parent = (idx - 1) / 2;
+
+        if (timer_at(s, parent)->deadline <= t.deadline)
+            break;
+
+        timer_place(s, idx, timer_at(s, parent));
+        idx = parent;
+    }
+
+    timer_place(s, idx, &t);
+}
+
+static
+void timer_sift_down(coroutine_scheduler_t *s, size_t idx) {
+    coroutine_timer_t t = *timer_at(s, idx);
+    size_t count = s->timers.count;
+    size_t child;
+
+    while ((child = 2 * idx + 1) < count) {
+        if (child + 1 < count &&
+            timer_at(s, child + 1)->deadline < timer_at(s, child)->deadline)
+            ++child;
+
+        if (t.deadline <= timer_at(s, child)->deadline)
+            break;
+
+        timer_place(s, idx, timer_at(s, child));
+        idx = child;
+    }
+
+    timer_place(s, idx, &t);
+}
+
+static
+void timers_update_next(coroutine_scheduler_t *s) {
+    atomic_store(&s->next_timer,
+                 s->timers.count
+                 ? timer_at(s, 0)->deadline : COROUTINE_TIMER_NONE);
+}
+
+static
+void timer_arm(coroutine_scheduler_t *s, coroutine_t *cr, uint64_t deadline) {
+    coroutine_timer_t *t;
+
+    assert(SIZE_MAX == cr->timer_idx);
+
+    t = vector_append(&s->timers);
+    t->deadline = deadline;
+    t->cr = cr;
+
+    timer_sift_up(s, s->timers.count - 1);
+    timers_update_next(s);
+}
+
+static
+void timer_disarm(coroutine_scheduler_t *s, coroutine_t *cr) {
+    size_t idx = cr->timer_idx;
+    size_t last = s->timers.count - 1;
+
+    assert(idx <= last && timer_at(s, idx)->cr == cr);
+
+    cr->timer_idx = SIZE_MAX;
+
+    if (idx != last) {
+        timer_place(s, idx, timer_at(s, last));
+        vector_remove(&s->timers, last);
+
+        if (idx && timer_at(s, (idx - 1) / 2)->deadline >
+                   timer_at(s, idx)->deadline)
+            timer_sift_up(s, idx);
+        else
+            timer_sift_down(s, idx);
+    }
+    else
+        vector_remove(&s->timers, last);
+
+    timers_update_next(s);
+}
+
+/* \return coroutine of the earliest timer expired by \c now, retained */
+static
+coroutine_t *timer_pop_expired(coroutine_scheduler_t *s, uint64_t now) {
+    coroutine_t *cr;
+
+    if (!s->timers.count || timer_at(s, 0)->deadline > now)
+        return NULL;
+
+    cr = timer_at(s, 0)->cr;
+
+    /* parked coroutine may return once disarmed, keep it for unpark */
+    coroutine_retain(cr);
+    timer_disarm(s, cr);
+
+    return cr;
+}
+
+/***************************** internal funcs *****************************/
+/* Not inlined so that thread local address is never cached
+ * across a context switch, coroutine may be resumed by another thread.
+ */
+__attribute__((noinline))
+coroutine_worker_t *coroutine_worker_current(void) {
+    return current_worker;
+}
+
+static
+void timespec_from_clock(struct timespec *ts, uint64_t t) {
+    ts->tv_sec = (time_t)(t / 1000000000ULL);
+    ts->tv_nsec = (long)(t % 1000000000ULL);
+}
+
+static inline
+bool timers_due(coroutine_scheduler_t *s, uint64_t *now) {
+    uint64_t next = atomic_load_explicit(&s->next_timer,
+                                         memory_order_relaxed);
+
+    if (COROUTINE_TIMER_NONE == next)
+        return false;
+
+    *now = coroutine_clock();
+
+    return next <= *now;
+}
+
+/* unpark coroutines whose deadlines passed */
+static
+void fire_timers(coroutine_scheduler_t *s, uint64_t now) {
+    coroutine_t *cr;
+
+    for (;;) {
+        pthread_mutex_lock(&s->mtx);
+        cr = timer_pop_expired(s, now);
+        pthread_mutex_unlock(&s->mtx);
+
+        if (!cr)
+            break;
+
+        coroutine_unpark(cr);
+        coroutine_release(cr);
+    }
+}
+
+static
+void wake_idle(coroutine_scheduler_t *s) {
+    /* order the push before reading idle counter */
+    atomic_thread_fence(memory_order_seq_cst);
+
+    if (!atomic_load(&s->idle))
+        return;
+
+    pthread_mutex_lock(&s->mtx);
+    pthread_cond_signal(&s->work_cond);
+    pthread_mutex_unlock(&s->mtx);
+}
+
+static
+void inject(coroutine_scheduler_t *s, coroutine_t *cr) {
+    pthread_mutex_lock(&s->mtx);
+
+    ilist_push_back(&s->injected, &cr->sched_link);
+    atomic_fetch_add(&s->injected_count, 1);
+
+    pthread_cond_signal(&s->work_cond);
+    pthread_mutex_unlock(&s->mtx);
+}
+
+/* should be called with s->mtx locked */
+static
+coroutine_t *take_injected_locked(coroutine_scheduler_t *s) {
+    ilist_link_t *link = ilist_pop_front(&s->injected);
+
+    if (!link)
+        return NULL;
+
+    atomic_fetch_sub(&s->injected_count, 1);
+
+    return ilist_entry(link, coroutine_t, sched_link);
+}
+
+static
+coroutine_t *take_injected(coroutine_scheduler_t *s) {
+    coroutine_t *cr;
+
+    if (!atomic_load(&s->injected_count))
+        return NULL;
+
+    pthread_mutex_lock(&s->mtx);
+    cr = take_injected_locked(s);
+    pthread_mutex_unlock(&s->mtx);
+
+    return cr;
+}
+
+static
+coroutine_t *steal(coroutine_worker_t *w) {
+    coroutine_scheduler_t *s = w->sched;
+    coroutine_t *cr;
+    size_t start, i, idx;
+    bool retry;
+
+    if (s->workers_count < 2)
+        return NULL;
+
+    do {
+        retry = false;
+        start = (size_t)rand_r(&w->seed);
+
+        for (i = 0; i < s->workers_count; ++i) {
+            idx = (start + i) % s->workers_count;
+
+            if (idx == w->idx)
+                continue;
+
+            cr = ws_deque_steal(&s->workers[idx].deque, &retry);
+
+            if (cr)
+                return cr;
+        }
+    } while (retry);
+
+    return NULL;
+}
+
+/* should be called with s->mtx locked */
+static
+bool any_deque_nonempty(coroutine_scheduler_t *s) {
+    size_t idx;
+
+    for (idx = 0; idx < s->workers_count; ++idx)
+        if (!ws_deque_empty(&s->workers[idx].deque))
+            return true;
+
+    return false;
+}
+
+/* \return runnable coroutine or \c NULL if scheduler is stopping */
+static
+coroutine_t *worker_find(coroutine_worker_t *w) {
+    coroutine_scheduler_t *s = w->sched;
+    coroutine_t *cr;
+    struct timespec ts;
+    uint64_t now, next;
+    bool recheck;
+
+    for (;;) {
+        if (timers_due(s, &now))
+            fire_timers(s, now);
+
+        if (!(++w->ticks % INJECTED_CHECK_INTERVAL) &&
+            (cr = take_injected(s)))
+            return cr;
+
+        if ((cr = ws_deque_take(&w->deque)))
+            return cr;
+
+        if ((cr = take_injected(s)))
+            return cr;
+
+        if ((cr = steal(w)))
+            return cr;
+
+        /* go idle, idle counter is raised before the last check
+         * so that a concurrent push either is seen here or wakes us up */
+        pthread_mutex_lock(&s->mtx);
+        atomic_fetch_add(&s->idle, 1);
+
+        recheck = false;
+
+        while (!atomic_load(&s->stopping)) {
+            if ((cr = take_injected_locked(s)))
+                break;
+
+            if (any_deque_nonempty(s)) {
+                recheck = true;
+                break;
+            }
+
+            next = atomic_load(&s->next_timer);
+
+            if (COROUTINE_TIMER_NONE == next) {
+                pthread_cond_wait(&s->work_cond, &s->mtx);
+                continue;
+            }
+
+            if (next <= coroutine_clock()) {
+                recheck = true;
+                break;
+            }
+
+            timespec_from_clock(&ts, next);
+            pthread_cond_timedwait(&s->work_cond, &s->mtx, &ts);
+        }
+
+        atomic_fetch_sub(&s->idle, 1);
+        pthread_mutex_unlock(&s->mtx);
+
+        if (cr)
+            return cr;
+
+        if (!recheck)
+            return NULL;
+    }
+}
+
+/* make runnable coroutine \c cr available to workers */
+static
+void schedule(coroutine_t *cr) {
+    coroutine_scheduler_t *s = cr->sched;
+    coroutine_worker_t *w = coroutine_worker_current();
+
+    if (w && w->sched == s) {
+        ws_deque_push(&w->deque, cr);
+        wake_idle(s);
+    }
+    else
+        inject(s, cr);
+}
+
+static
+void coroutine_finished(coroutine_scheduler_t *s, coroutine_t *cr) {
+    coroutine_release(cr);
+
+    if (1 == atomic_fetch_sub(&s->live, 1)) {
+        pthread_mutex_lock(&s->mtx);
+        pthread_cond_broadcast(&s->done_cond);
+        pthread_mutex_unlock(&s->mtx);
+    }
+}
+
+static
+void worker_run(coroutine_worker_t *w, coroutine_t *cr) {
+    int state = CR_SCHED_RUNNABLE;
+
+    /* unpark of queued coroutine is kept for its next park */
+    atomic_compare_exchange_strong(&cr->sched_state, &state,
+                                   CR_SCHED_RUNNING);
+    assert(CR_SCHED_RUNNABLE == state || CR_SCHED_NOTIFIED == state);
+
+    w->current = cr;
+
+    coroutine_continue(cr);
+
+    w->current = NULL;
+
+    if (coroutine_returned(cr)) {
+        coroutine_finished(w->sched, cr);
+        return;
+    }
+
+    switch (cr->sched_request) {
+        case CR_SCHED_REQ_PARK:
+            state = CR_SCHED_RUNNING;
+
+            if (atomic_compare_exchange_strong(&cr->sched_state, &state,
+                                               CR_SCHED_PARKED))
+                break;
+
+            /* unparked while switching out */
+            assert(CR_SCHED_NOTIFIED == state);
+
+            atomic_store(&cr->sched_state, CR_SCHED_RUNNABLE);
+            ws_deque_push(&w->deque, cr);
+            break;
+
+        case CR_SCHED_REQ_YIELD:
+        default:
+            /* pending unpark survives the yield */
+            state = CR_SCHED_RUNNING;
+            atomic_compare_exchange_strong(&cr->sched_state, &state,
+                                           CR_SCHED_RUNNABLE);
+
+            /* to the end of the queue so that others have their turn */
+            inject(w->sched, cr);
+            break;
+    }
+}
+
+static
+void *worker_main(void *arg) {
+    coroutine_worker_t *w = arg;
+    coroutine_t *cr;
+
+    current_worker = w;
+
+    while ((cr = worker_find(w)))
+        worker_run(w, cr);
+
+    current_worker = NULL;
+
+    return NULL;
+}
+
+/***************************** API *****************************/
+void coroutine_scheduler_init(coroutine_scheduler_t *s, size_t workers_count) {
+    coroutine_worker_t *w;
+    pthread_condattr_t attr;
+    size_t idx;
+    int rc;
+
+    assert(s);
+
+    if (!workers_count) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        workers_count = cpus > 0 ? (size_t)cpus : 1;
+    }
+
+    ilist_init(&s->injected);
+    atomic_init(&s->injected_count, 0);
+    atomic_init(&s->live, 0);
+    atomic_init(&s->idle, 0);
+    atomic_init(&s->stopping, false);
+
+    vector_init(&s->timers, sizeof(coroutine_timer_t), 0);
+    atomic_init(&s->next_timer, COROUTINE_TIMER_NONE);
+
+    rc = pthread_mutex_init(&s->mtx, NULL);
+    assert(0 == rc);
+
+    /* idle workers sleep until the next coroutine_clock() deadline */
+    rc = pthread_condattr_init(&attr);
+    assert(0 == rc);
+    rc = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    assert(0 == rc);
+    rc = pthread_cond_init(&s->work_cond, &attr);
+    assert(0 == rc);
+    pthread_condattr_destroy(&attr);
+
+    rc = pthread_cond_init(&s->done_cond, NULL);
+    assert(0 == rc);
+
+    s->workers_count = workers_count;
+    s->workers = malloc(workers_count * sizeof(*s->workers));
+    assert(s->workers);
+
+    for (idx = 0; idx < workers_count; ++idx) {
+        w = &s->workers[idx];
+
+        w->sched = s;
+        w->idx = idx;
+        w->current = NULL;
+        w->seed = (unsigned int)idx + 1;
+        w->ticks = 0;
+
+        ws_deque_init(&w->deque);
+    }
+
+    for (idx = 0; idx < workers_count; ++idx) {
+        rc = pthread_create(&s->workers[idx].thread, NULL,
+                            worker_main, &s->workers[idx]);
+        assert(0 == rc);
+    }
+
+    DONT_USE(rc);
+}
+
+void coroutine_scheduler_deinit(coroutine_scheduler_t *s) {
+    size_t idx;
+
+    assert(s);
+
+    pthread_mutex_lock(&s->mtx);
+    atomic_store(&s->stopping, true);
+    pthread_cond_broadcast(&s->work_cond);
+    pthread_mutex_unlock(&s->mtx);
+
+    for (idx = 0; idx < s->workers_count; ++idx)
+        pthread_join(s->workers[idx].thread, NULL);
+
+    for (idx = 0; idx < s->workers_count; ++idx)
+        ws_deque_deinit(&s->workers[idx].deque);
+
+    free(s->workers);
+    s->workers = NULL;
+    s->workers_count = 0;
+
+    /* injected coroutines that did not return are leaked */
+    ilist_init(&s->injected);
+
+    /* timers of leaked coroutines */
+    while (s->timers.count)
+        timer_disarm(s, timer_at(s, 0)->cr);
+
+    vector_deinit(&s->timers);
+
+    pthread_cond_destroy(&s->done_cond);
+    pthread_cond_destroy(&s->work_cond);
+    pthread_mutex_destroy(&s->mtx);
+}
+
+void coroutine_scheduler_wait(coroutine_scheduler_t *s) {
+    assert(s);
+
+    pthread_mutex_lock(&s->mtx);
+
+    while (atomic_load(&s->live))
+        pthread_cond_wait(&s->done_cond, &s->mtx);
+
+    pthread_mutex_unlock(&s->mtx);
+}
+
+coroutine_t *coroutine_spawn(coroutine_scheduler_t *s,
+                             coroutine_cb_t cb, void *ctx,
+                             size_t stack_size) {
+    coroutine_t *cr;
+
+    assert(s);
+
+    cr = malloc(sizeof(*cr));
+    assert(cr);
+
+    coroutine_init(cr, cb, ctx, stack_size);
+    cr->sched = s;
+
+    atomic_fetch_add(&s->live, 1);
+
+    schedule(cr);
+
+    return cr;
+}
+
+void coroutine_scheduler_yield(coroutine_t *cr) {
+    assert(cr && cr->sched);
+
+    cr->sched_request = CR_SCHED_REQ_YIELD;
+    coroutine_yield(cr);
+}
+
+void coroutine_park(coroutine_t *cr) {
+    int state = CR_SCHED_NOTIFIED;
+
+    assert(cr && cr->sched);
+
+    /* consume pending unpark */
+    if (atomic_compare_exchange_strong(&cr->sched_state, &state,
+                                       CR_SCHED_RUNNING))
+        return;
+
+    cr->sched_request = CR_SCHED_REQ_PARK;
+    coroutine_yield(cr);
+}
+
+bool coroutine_park_until(coroutine_t *cr, uint64_t deadline) {
+    coroutine_scheduler_t *s;
+    bool armed;
+
+    assert(cr && cr->sched);
+
+    s = cr->sched;
+
+    if (deadline <= coroutine_clock())
+        return false;
+
+    pthread_mutex_lock(&s->mtx);
+
+    timer_arm(s, cr, deadline);
+
+    /* wake an idle worker up to sleep until the new deadline */
+    if (!cr->timer_idx)
+        pthread_cond_signal(&s->work_cond);
+
+    pthread_mutex_unlock(&s->mtx);
+
+    coroutine_park(cr);
+
+    /* timer is disarmed when fired */
+    pthread_mutex_lock(&s->mtx);
+
+    armed = SIZE_MAX != cr->timer_idx;
+
+    if (armed)
+        timer_disarm(s, cr);
+
+    pthread_mutex_unlock(&s->mtx);
+
+    return armed;
+}
+
+void coroutine_sleep(coroutine_t *cr, uint64_t duration) {
+    uint64_t deadline;
+
+    assert(cr && cr->sched);
+
+    deadline = coroutine_clock() + duration;
+
+    while (coroutine_park_until(cr, deadline));
+}
+
+uint64_t coroutine_clock(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void coroutine_retain(coroutine_t *cr) {
+    assert(cr && cr->sched);
+
+    atomic_fetch_add_explicit(&cr->refs, 1, memory_order_relaxed);
+}
+
+void coroutine_release(coroutine_t *cr) {
+    assert(cr && cr->sched);
+
+    if (1 != atomic_fetch_sub_explicit(&cr->refs, 1, memory_order_acq_rel))
+        return;
+
+    coroutine_deinit(cr);
+    free(cr);
+}
+
+void coroutine_unpark(coroutine_t *cr) {
+    int state;
+
+    assert(cr && cr->sched);
+
+    state = atomic_load(&cr->sched_state);
+
+    for (;;) {
+        switch (state) {
+            case CR_SCHED_PARKED:
+                if (atomic_compare_exchange_weak(&cr->sched_state, &state,
+                                                 CR_SCHED_RUNNABLE)) {
+                    schedule(cr);
+                    return;
+                }
+                break;
+
+            case CR_SCHED_RUNNING:
+            case CR_SCHED_RUNNABLE:
+                /* queued or running one won't park on next attempt */
+                if (atomic_compare_exchange_weak(&cr->sched_state, &state,
+                                                 CR_SCHED_NOTIFIED))
+                    return;
+                break;
+
+            default:
+                /* already notified */
+                return;
+        }
+    }
+}
+
+/***************************** WAITERS *****************************/
+void coroutine_waiter_init(coroutine_waiter_t *w, coroutine_t *cr,
+                           void *data) {
+    assert(w && cr);
+
+    w->cr = cr;
+    w->prev = w->next = NULL;
+    atomic_init(&w->woken, false);
+    w->result = 0;
+    w->data = data;
+    w->queued = false;
+}
+
+int coroutine_waiter_wait(coroutine_waiter_t *w) {
+    assert(w);
+
+    while (!atomic_load_explicit(&w->woken, memory_order_acquire))
+        coroutine_park(w->cr);
+
+    return w->result;
+}
+
+bool coroutine_waiter_wait_until(coroutine_waiter_t *w, uint64_t deadline) {
+    assert(w);
+
+    while (!atomic_load_explicit(&w->woken, memory_order_acquire))
+        if (!coroutine_park_until(w->cr, deadline))
+            return atomic_load_explicit(&w->woken, memory_order_acquire);
+
+    return true;
+}
+
+void coroutine_waiter_wake(coroutine_waiter_t *w, int result) {
+    coroutine_t *cr;
+
+    assert(w);
+
+    cr = w->cr;
+
+    /* waiter may leave and even return as soon as woken is set */
+    coroutine_retain(cr);
+
+    w->result = result;
+    atomic_store_explicit(&w->woken, true, memory_order_release);
+
+    coroutine_unpark(cr);
+    coroutine_release(cr);
+}
+
+void coroutine_wait_queue_init(coroutine_wait_queue_t *q) {
+    assert(q);
+
+    q->front = q->back = NULL;
+    q->count = 0;
+}
+
+bool coroutine_wait_queue_empty(const coroutine_wait_queue_t *q) {
+    assert(q);
+
+    return !q->count;
+}
+
+void coroutine_wait_queue_push(coroutine_wait_queue_t *q,
+                               coroutine_waiter_t *w) {
+    assert(q && w);
+
+    w->next = NULL;
+    w->prev = q->back;
+
+    if (q->back)
+        q->back->next = w;
+    else
+        q->front = w;
+
+    q->back = w;
+    ++q->count;
+
+    w->queued = true;
+}
+
+coroutine_waiter_t *coroutine_wait_queue_pop(coroutine_wait_queue_t *q) {
+    coroutine_waiter_t *w;
+
+    assert(q);
+
+    w = q->front;
+
+    if (w)
+        coroutine_wait_queue_remove(q, w);
+
+    return w;
+}
+
+void coroutine_wait_queue_remove(coroutine_wait_queue_t *q,
+                                 coroutine_waiter_t *w) {
+    assert(q && w && q->count);
+
+    if (w->prev)
+        w->prev->next = w->next;
+    else
+        q->front = w->next;
+
+    if (w->next)
+        w->next->prev = w->prev;
+    else
+        q->back = w->prev;
+
+    w->prev = w->next = NULL;
+    w->queued = false;
+    --q->count;
+}
@@ -0,0 +1,406 @@
+#include "coroutine-sync.h"
+#include "coroutine-scheduler.h"
+#include "common.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <assert.h>
+
+/******************************* internal funcs *******************************/
+static
+void guard_init(pthread_mutex_t *guard) {
+    int rc = pthread_mutex_init(guard, NULL);
+
+    assert(0 == rc);
+    DONT_USE(rc);
+}
+
+/* should be called with guard locked, unlocks it */
+static
+void park_in(coroutine_wait_queue_t *q, pthread_mutex_t *guard,
+             coroutine_t *cr) {
+    coroutine_waiter_t w;
+
+    coroutine_waiter_init(&w, cr, NULL);
+    coroutine_wait_queue_push(q, &w);
+
+    pthread_mutex_unlock(guard);
+
+    coroutine_waiter_wait(&w);
+}
+
+/* timed out waiter \c w leaves queue \c q unless a waker took it already
+ * \return \c true if \c w was taken and is woken by now
+ */
+static
+bool leave_or_wait(coroutine_wait_queue_t *q, pthread_mutex_t *guard,
+                   coroutine_waiter_t *w) {
+    pthread_mutex_lock(guard);
+
+    if (w->queued) {
+        coroutine_wait_queue_remove(q, w);
+        pthread_mutex_unlock(guard);
+        return false;
+    }
+
+    pthread_mutex_unlock(guard);
+
+    coroutine_waiter_wait(w);
+
+    return true;
+}
+
+/* should be called with guard locked, unlocks it
+ * \return \c false if \c deadline passed before being woken
+ */
+static
+bool park_in_until(coroutine_wait_queue_t *q, pthread_mutex_t *guard,
+                   coroutine_t *cr, uint64_t deadline) {
+    coroutine_waiter_t w;
+
+    coroutine_waiter_init(&w, cr, NULL);
+    coroutine_wait_queue_push(q, &w);
+
+    pthread_mutex_unlock(guard);
+
+    if (coroutine_waiter_wait_until(&w, deadline))
+        return true;
+
+    return leave_or_wait(q, guard, &w);
+}
+
+/* wake every waiter of \c q, guard should be locked, unlocks it */
+static
+void wake_all(coroutine_wait_queue_t *q, pthread_mutex_t *guard) {
+    coroutine_waiter_t *w, *next;
+
+    w = q->front;
+
+    /* timed out waiters should see they're taken */
+    for (next = w; next; next = next->next)
+        next->queued = false;
+
+    coroutine_wait_queue_init(q);
+
+    pthread_mutex_unlock(guard);
+
+    for (; w; w = next) {
+        next = w->next;
+        coroutine_waiter_wake(w, 0);
+    }
+}
+
+/******************************* MUTEX *******************************/
+void coroutine_mutex_init(coroutine_mutex_t *m) {
+    assert(m);
+
+    guard_init(&m->guard);
+    m->locked = false;
+    coroutine_wait_queue_init(&m->waiters);
+}
+
+void coroutine_mutex_deinit(coroutine_mutex_t *m) {
+    assert(m);
+    assert(!m->locked && coroutine_wait_queue_empty(&m->waiters));
+
+    pthread_mutex_destroy(&m->guard);
+}
+
+void coroutine_mutex_lock(coroutine_mutex_t *m, coroutine_t *cr) {
+    assert(m && cr);
+
+    pthread_mutex_lock(&m->guard);
+
+    if (!m->locked) {
+        m->locked = true;
+        pthread_mutex_unlock(&m->guard);
+        return;
+    }
+
+    /* ownership is handed over by unlocker */
+    park_in(&m->waiters, &m->guard, cr);
+}
+
+bool coroutine_mutex_lock_for(coroutine_mutex_t *m, coroutine_t *cr,
+                              uint64_t timeout) {
+    uint64_t deadline = coroutine_clock() + timeout;
+
+    assert(m && cr);
+
+    pthread_mutex_lock(&m->guard);
+
+    if (!m->locked) {
+        m->locked = true;
+        pthread_mutex_unlock(&m->guard);
+        return true;
+    }
+
+    return park_in_until(&m->waiters, &m->guard, cr, deadline);
+}
+
+bool coroutine_mutex_trylock(coroutine_mutex_t *m) {
+    bool locked = false;
+
+    assert(m);
+
+    pthread_mutex_lock(&m->guard);
+
+    if (!m->locked)
+        locked = m->locked = true;
+
+    pthread_mutex_unlock(&m->guard);
+
+    return locked;
+}
+
+void coroutine_mutex_unlock(coroutine_mutex_t *m) {
+    coroutine_waiter_t *w;
+
+    assert(m);
+
+    pthread_mutex_lock(&m->guard);
+
+    assert(m->locked);
+
+    w = coroutine_wait_queue_pop(&m->waiters);
+
+    /* mutex stays locked when handed over */
+    if (!w)
+        m->locked = false;
+
+    pthread_mutex_unlock(&m->guard);
+
+    if (w)
+        coroutine_waiter_wake(w, 0);
+}
+
+/******************************* SEMAPHORE *******************************/
+void coroutine_sem_init(coroutine_sem_t *s, size_t count) {
+    assert(s);
+
+    guard_init(&s->guard);
+    s->count = count;
+    coroutine_wait_queue_init(&s->waiters);
+}
+
+void coroutine_sem_deinit(coroutine_sem_t *s) {
+    assert(s);
+    assert(coroutine_wait_queue_empty(&s->waiters));
+
+    pthread_mutex_destroy(&s->guard);
+}
+
+void coroutine_sem_wait(coroutine_sem_t *s, coroutine_t *cr) {
+    assert(s && cr);
+
+    pthread_mutex_lock(&s->guard);
+
+    if (s->count) {
+        --s->count;
+        pthread_mutex_unlock(&s->guard);
+        return;
+    }
+
+    park_in(&s->waiters, &s->guard, cr);
+}
+
+bool coroutine_sem_wait_for(coroutine_sem_t *s, coroutine_t *cr,
+                            uint64_t timeout) {
+    uint64_t deadline = coroutine_clock() + timeout;
+
+    assert(s && cr);
+
+    pthread_mutex_lock(&s->guard);
+
+    if (s->count) {
+        --s->count;
+        pthread_mutex_unlock(&s->guard);
+        return true;
+    }
+
+    return park_in_until(&s->waiters, &s->guard, cr, deadline);
+}
+
+bool coroutine_sem_trywait(coroutine_sem_t *s) {
+    bool decremented = false;
+
+    assert(s);
+
+    pthread_mutex_lock(&s->guard);
+
+    if (s->count) {
+        --s->count;
+        decremented = true;
+    }
+
+    pthread_mutex_unlock(&s->guard);
+
+    return decremented;
+}
+
+void coroutine_sem_post(coroutine_sem_t *s) {
+    coroutine_waiter_t *w;
+
+    assert(s);
+
+    pthread_mutex_lock(&s->guard);
+
+    w = coroutine_wait_queue_pop(&s->waiters);
+
+    if (!w)
+        ++s->count;
+
+    pthread_mutex_unlock(&s->guard);
+
+    if (w)
+        coroutine_waiter_wake(w, 0);
+}
+
+/******************************* CONDITION *******************************/
+void coroutine_cond_init(coroutine_cond_t *c) {
+    assert(c);
+
+    guard_init(&c->guard);
+    coroutine_wait_queue_init(&c->waiters);
+}
+
+void coroutine_cond_deinit(coroutine_cond_t *c) {
+    assert(c);
+    assert(coroutine_wait_queue_empty(&c->waiters));
+
+    pthread_mutex_destroy(&c->guard);
+}
+
+void coroutine_cond_wait(coroutine_cond_t *c, coroutine_mutex_t *m,
+                         coroutine_t *cr) {
+    coroutine_waiter_t w;
+
+    assert(c && m && cr);
+
+    coroutine_waiter_init(&w, cr, NULL);
+
+    /* enqueue before unlocking so that no signal is missed */
+    pthread_mutex_lock(&c->guard);
+    coroutine_wait_queue_push(&c->waiters, &w);
+    pthread_mutex_unlock(&c->guard);
+
+    coroutine_mutex_unlock(m);
+
+    coroutine_waiter_wait(&w);
+
+    coroutine_mutex_lock(m, cr);
+}
+
+bool coroutine_cond_wait_for(coroutine_cond_t *c, coroutine_mutex_t *m,
+                             coroutine_t *cr, uint64_t timeout) {
+    uint64_t deadline = coroutine_clock() + timeout;
+    coroutine_waiter_t w;
+    bool signalled;
+
+    assert(c && m && cr);
+
+    coroutine_waiter_init(&w, cr, NULL);
+
+    pthread_mutex_lock(&c->guard);
+    coroutine_wait_queue_push(&c->waiters, &w);
+    pthread_mutex_unlock(&c->guard);
+
+    coroutine_mutex_unlock(m);
+
+    signalled = coroutine_waiter_wait_until(&w, deadline) ||
+                leave_or_wait(&c->waiters, &c->guard, &w);
+
+    coroutine_mutex_lock(m, cr);
+
+    return signalled;
+}
+
+void coroutine_cond_signal(coroutine_cond_t *c) {
+    coroutine_waiter_t *w;
+
+    assert(c);
+
+    pthread_mutex_lock(&c->guard);
+    w = coroutine_wait_queue_pop(&c->waiters);
+    pthread_mutex_unlock(&c->guard);
+
+    if (w)
+        coroutine_waiter_wake(w, 0);
+}
+
+void coroutine_cond_broadcast(coroutine_cond_t *c) {
+    assert(c);
+
+    pthread_mutex_lock(&c->guard);
+    wake_all(&c->waiters, &c->guard);
+}
+
+/******************************* WAIT GROUP *******************************/
+void coroutine_wait_group_init(coroutine_wait_group_t *wg) {
+    assert(wg);
+
+    guard_init(&wg->guard);
+    wg->count = 0;
+    coroutine_wait_queue_init(&wg->waiters);
+}
+
+void coroutine_wait_group_deinit(coroutine_wait_group_t *wg) {
+    assert(wg);
+    assert(coroutine_wait_queue_empty(&wg->waiters));
+
+    pthread_mutex_destroy(&wg->guard);
+}
+
+void coroutine_wait_group_add(coroutine_wait_group_t *wg, size_t count) {
+    assert(wg);
+
+    pthread_mutex_lock(&wg->guard);
+    wg->count += count;
+    pthread_mutex_unlock(&wg->guard);
+}
+
+void coroutine_wait_group_done(coroutine_wait_group_t *wg) {
+    assert(wg);
+
+    pthread_mutex_lock(&wg->guard);
+
+    assert(wg->count);
+
+    if (--wg->count) {
+        pthread_mutex_unlock(&wg->guard);
+        return;
+    }
+
+    wake_all(&wg->waiters, &wg->guard);
+}
+
+void coroutine_wait_group_wait(coroutine_wait_group_t *wg, coroutine_t *cr) {
+    assert(wg && cr);
+
+    pthread_mutex_lock(&wg->guard);
+
+    if (!wg->count) {
+        pthread_mutex_unlock(&wg->guard);
+        return;
+    }
+
+    park_in(&wg->waiters, &wg->guard, cr);
+}
+
+bool coroutine_wait_group_wait_for(coroutine_wait_group_t *wg,
+                                   coroutine_t *cr, uint64_t timeout) {
+    uint64_t deadline = coroutine_clock() + timeout;
+
+    assert(wg && cr);
+
+    pthread_mutex_lock(&wg->guard);
+
+    if (!wg->count) {
+        pthread_mutex_unlock(&wg->guard);
+        return true;
+    }
+
+    return park_in_until(&wg->waiters, &wg->guard, cr, deadline);
+}
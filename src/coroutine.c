@@ -1,8 +1,440 @@
 #include "coroutine.h"
 #include "common.h"
 
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
 #include <assert.h>
 
+/***************************** STACK *****************************/
+/* lives at the top of cached stack */
+typedef struct cached_stack {
+    struct cached_stack *next;
+    coroutine_stack_t stack;
+} cached_stack_t;
+
+static pthread_key_t local_pool_key;
+static pthread_once_t local_pool_key_once = PTHREAD_ONCE_INIT;
+static __thread coroutine_stack_pool_t *local_pool = NULL;
+/* the pool was destroyed on thread exit, no new one should be created */
+static __thread bool local_pool_gone = false;
+
+static __thread coroutine_t *current_coroutine = NULL;
+static atomic_size_t keys_count = 0;
+
+static inline
+size_t page_size(void) {
+    static size_t ps = 0;
+
+    if (!ps)
+        ps = (size_t)sysconf(_SC_PAGESIZE);
+
+    return ps;
+}
+
+static
+void local_pool_destroy(void *pool) {
+    /* other keys' destructors might still release stacks */
+    local_pool = NULL;
+    local_pool_gone = true;
+
+    coroutine_stack_pool_deinit(pool);
+    free(pool);
+}
+
+static
+void local_pool_key_create(void) {
+    int rc = pthread_key_create(&local_pool_key, local_pool_destroy);
+
+    assert(0 == rc);
+    DONT_USE(rc);
+}
+
+static
+void stack_map(coroutine_stack_t *st, size_t size) {
+    size_t ps = page_size();
+    int rc;
+
+    size = (size + ps - 1) & ~(ps - 1);
+
+    st->map_size = size + ps;
+    st->map = mmap(NULL, st->map_size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK,
+                   -1, 0);
+
+    assert(MAP_FAILED != st->map);
+
+    /* stack grows down, guard its lower end */
+    rc = mprotect(st->map, ps, PROT_NONE);
+
+    assert(0 == rc);
+    DONT_USE(rc);
+
+    st->data = (char *)st->map + ps;
+    st->size = size;
+    st->painted = false;
+}
+
+static
+void stack_unmap(coroutine_stack_t *st) {
+    int rc = munmap(st->map, st->map_size);
+
+    assert(0 == rc);
+    DONT_USE(rc);
+
+    st->map = st->data = NULL;
+    st->map_size = st->size = 0;
+}
+
+static
+size_t stack_used_painted(const coroutine_stack_t *st) {
+    static const uint64_t paint = 0x0101010101010101ULL * COROUTINE_STACK_PAINT;
+    const uint64_t *w = st->data;
+    const uint64_t *end = (const uint64_t *)((char *)st->data + st->size);
+
+    /* stack grows down, scan from its lower end */
+    while (w < end && *w == paint)
+        ++w;
+
+    return (size_t)((const char *)end - (const char *)w);
+}
+
+static
+size_t stack_used_resident(const coroutine_stack_t *st) {
+    size_t ps = page_size();
+    size_t pages = st->size / ps;
+    size_t idx;
+    unsigned char *vec;
+    int rc;
+
+    vec = malloc(pages);
+    assert(vec);
+
+    rc = mincore(st->data, st->size, vec);
+    assert(0 == rc);
+    DONT_USE(rc);
+
+    for (idx = 0; idx < pages && !(vec[idx] & 0x01); ++idx);
+
+    free(vec);
+
+    return (pages - idx) * ps;
+}
+
+void coroutine_stack_pool_init(coroutine_stack_pool_t *pool,
+                               size_t max_cached) {
+    assert(pool);
+
+    pool->cached = NULL;
+    pool->cached_count = 0;
+    pool->max_cached = max_cached;
+    pool->paint = false;
+
+    memset(&pool->stats, 0, sizeof(pool->stats));
+}
+
+void coroutine_stack_pool_set_paint(coroutine_stack_pool_t *pool,
+                                    bool paint) {
+    assert(pool);
+
+    pool->paint = paint;
+}
+
+size_t coroutine_stack_used(const coroutine_stack_t *st) {
+    assert(st);
+
+    if (!st->map)
+        return 0;
+
+    return st->painted ? stack_used_painted(st) : stack_used_resident(st);
+}
+
+void coroutine_stack_pool_deinit(coroutine_stack_pool_t *pool) {
+    cached_stack_t *cs, *next;
+    coroutine_stack_t st;
+
+    assert(pool);
+
+    for (cs = pool->cached; cs; cs = next) {
+        next = cs->next;
+        st = cs->stack;
+        stack_unmap(&st);
+    }
+
+    pool->cached = NULL;
+    pool->cached_count = 0;
+}
+
+coroutine_stack_pool_t *coroutine_stack_pool_local(void) {
+    int rc;
+
+    if (local_pool)
+        return local_pool;
+
+    rc = pthread_once(&local_pool_key_once, local_pool_key_create);
+    assert(0 == rc);
+
+    local_pool = malloc(sizeof(*local_pool));
+    assert(local_pool);
+
+    coroutine_stack_pool_init(local_pool,
+                              COROUTINE_STACK_POOL_DEFAULT_MAX_CACHED);
+
+    rc = pthread_setspecific(local_pool_key, local_pool);
+    assert(0 == rc);
+    DONT_USE(rc);
+
+    return local_pool;
+}
+
+void coroutine_stack_alloc(coroutine_stack_pool_t *pool,
+                           coroutine_stack_t *st, size_t size) {
+    size_t ps = page_size();
+    cached_stack_t *cs, **link;
+    bool found = false;
+
+    assert(pool && st);
+
+    size = (size + ps - 1) & ~(ps - 1);
+
+    for (link = (cached_stack_t **)&pool->cached; *link;
+         link = &(*link)->next) {
+        cs = *link;
+
+        if (cs->stack.size != size)
+            continue;
+
+        *link = cs->next;
+        --pool->cached_count;
+
+        *st = cs->stack;
+        found = true;
+        break;
+    }
+
+    if (!found) {
+        stack_map(st, size);
+        ++pool->stats.mapped;
+    }
+
+    ++pool->stats.allocated;
+
+    st->painted = pool->paint;
+
+    if (st->painted)
+        memset(st->data, COROUTINE_STACK_PAINT, st->size);
+}
+
+void coroutine_stack_release(coroutine_stack_pool_t *pool,
+                             coroutine_stack_t *st) {
+    cached_stack_t *cs;
+    size_t used;
+
+    assert(pool && st);
+
+    if (!st->map)
+        return;
+
+    ++pool->stats.released;
+
+    if (st->painted) {
+        used = stack_used_painted(st);
+
+        ++pool->stats.measured;
+        pool->stats.usage_total += used;
+
+        if (used > pool->stats.usage_max)
+            pool->stats.usage_max = used;
+    }
+
+    if (pool->cached_count >= pool->max_cached) {
+        stack_unmap(st);
+        return;
+    }
+
+    cs = (cached_stack_t *)((char *)st->data + st->size) - 1;
+    cs->stack = *st;
+    cs->next = pool->cached;
+
+    pool->cached = cs;
+    ++pool->cached_count;
+
+    st->map = st->data = NULL;
+    st->map_size = st->size = 0;
+}
+
+/***************************** CONTEXT *****************************/
+
+#ifdef COROUTINE_FAST_SWITCH
+/* Save callee-saved registers on current stack, store stack pointer
+ * to *from_sp, switch to stack at to_sp and restore registers from there.
+ */
+void _coroutine_switch(void **from_sp, void *to_sp)
+    __attribute__((visibility("hidden")));
+/* First switch to a fresh coroutine lands here.
+ * Coroutine pointer is passed in a callee-saved register.
+ */
+void _coroutine_trampoline(void)
+    __attribute__((visibility("hidden")));
+void _coroutine_entry(coroutine_t *cr)
+    __attribute__((visibility("hidden"), noreturn, used));
+
+# if defined(__x86_64__)
+/* Frame layout from the saved stack pointer up:
+ * mxcsr + x87 control word, r15, r14, r13, r12, rbx, rbp, return address
+ */
+#  define FRAME_WORDS           8
+#  define FRAME_FPU             0
+#  define FRAME_ARG             4       /* r12 */
+#  define FRAME_FP              6       /* rbp */
+#  define FRAME_RET             7
+#  define FPU_DEFAULT           (0x1f80 | ((uint64_t)0x037f << 32))
+
+__asm__ (
+    ".pushsection .text\n"
+    ".p2align 4\n"
+    ".globl _coroutine_switch\n"
+    ".hidden _coroutine_switch\n"
+    ".type _coroutine_switch, @function\n"
+    "_coroutine_switch:\n"
+    "    pushq %rbp\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    subq $8, %rsp\n"
+    "    stmxcsr (%rsp)\n"
+    "    fnstcw 4(%rsp)\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq %rsi, %rsp\n"
+    "    ldmxcsr (%rsp)\n"
+    "    fldcw 4(%rsp)\n"
+    "    addq $8, %rsp\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    popq %rbp\n"
+    "    ret\n"
+    ".size _coroutine_switch, .-_coroutine_switch\n"
+    "\n"
+    ".p2align 4\n"
+    ".globl _coroutine_trampoline\n"
+    ".hidden _coroutine_trampoline\n"
+    ".type _coroutine_trampoline, @function\n"
+    "_coroutine_trampoline:\n"
+    "    movq %r12, %rdi\n"
+    "    call _coroutine_entry\n"
+    "    ud2\n"
+    ".size _coroutine_trampoline, .-_coroutine_trampoline\n"
+    ".popsection\n"
+);
+# elif defined(__aarch64__)
+/* Frame layout from the saved stack pointer up:
+ * x19 - x28, x29 (fp), x30 (lr), d8 - d15
+ */
+#  define FRAME_WORDS           20
+#  define FRAME_FPU             -1
+#  define FRAME_ARG             0       /* x19 */
+#  define FRAME_FP              10      /* x29 */
+#  define FRAME_RET             11      /* x30 */
+#  define FPU_DEFAULT           0
+
+__asm__ (
+    ".pushsection .text\n"
+    ".p2align 4\n"
+    ".globl _coroutine_switch\n"
+    ".hidden _coroutine_switch\n"
+    ".type _coroutine_switch, %function\n"
+    "_coroutine_switch:\n"
+    "    sub sp, sp, #160\n"
+    "    stp x19, x20, [sp, #0]\n"
+    "    stp x21, x22, [sp, #16]\n"
+    "    stp x23, x24, [sp, #32]\n"
+    "    stp x25, x26, [sp, #48]\n"
+    "    stp x27, x28, [sp, #64]\n"
+    "    stp x29, x30, [sp, #80]\n"
+    "    stp d8, d9, [sp, #96]\n"
+    "    stp d10, d11, [sp, #112]\n"
+    "    stp d12, d13, [sp, #128]\n"
+    "    stp d14, d15, [sp, #144]\n"
+    "    mov x2, sp\n"
+    "    str x2, [x0]\n"
+    "    mov sp, x1\n"
+    "    ldp x19, x20, [sp, #0]\n"
+    "    ldp x21, x22, [sp, #16]\n"
+    "    ldp x23, x24, [sp, #32]\n"
+    "    ldp x25, x26, [sp, #48]\n"
+    "    ldp x27, x28, [sp, #64]\n"
+    "    ldp x29, x30, [sp, #80]\n"
+    "    ldp d8, d9, [sp, #96]\n"
+    "    ldp d10, d11, [sp, #112]\n"
+    "    ldp d12, d13, [sp, #128]\n"
+    "    ldp d14, d15, [sp, #144]\n"
+    "    add sp, sp, #160\n"
+    "    ret\n"
+    ".size _coroutine_switch, .-_coroutine_switch\n"
+    "\n"
+    ".p2align 4\n"
+    ".globl _coroutine_trampoline\n"
+    ".hidden _coroutine_trampoline\n"
+    ".type _coroutine_trampoline, %function\n"
+    "_coroutine_trampoline:\n"
+    "    mov x0, x19\n"
+    "    bl _coroutine_entry\n"
+    "    brk #0\n"
+    ".size _coroutine_trampoline, .-_coroutine_trampoline\n"
+    ".popsection\n"
+);
+# endif
+
+void _coroutine_entry(coroutine_t *cr) {
+    assert(cr);
+
+    if (cr->cb)
+        cr->cb(cr, cr->ctx);
+
+    cr->returned = true;
+
+    _coroutine_switch(&cr->callee.sp, cr->resume->sp);
+
+    /* returned coroutine is never switched to again */
+    abort();
+}
+
+static inline
+void context_make(coroutine_t *cr) {
+    uintptr_t top;
+    uint64_t *frame;
+
+    /* keep stack top 16-byte aligned with some room above */
+    top = ((uintptr_t)cr->stack.data + cr->stack.size) & ~(uintptr_t)0x0f;
+    frame = (uint64_t *)(top - 0x10) - FRAME_WORDS;
+
+    memset(frame, 0, FRAME_WORDS * sizeof(*frame));
+
+    if (FRAME_FPU >= 0)
+        frame[FRAME_FPU] = FPU_DEFAULT;
+
+    frame[FRAME_ARG] = (uint64_t)cr;
+    frame[FRAME_FP] = 0;
+    frame[FRAME_RET] = (uint64_t)_coroutine_trampoline;
+
+    cr->callee.sp = frame;
+    cr->caller.sp = NULL;
+    cr->resume = &cr->caller;
+}
+
+static inline
+void context_switch(coroutine_context_t *from, coroutine_context_t *to) {
+    _coroutine_switch(&from->sp, to->sp);
+}
+#else
 void _caller(uint32_t dw1, uint32_t dw2) {
     uint64_t qw = dw2;
     coroutine_t *cr;
@@ -17,28 +449,26 @@ void _caller(uint32_t dw1, uint32_t dw2) {
         cr->cb(cr, cr->ctx);
 
     cr->returned = true;
+
+    /* uc_link can't follow transfers */
+    setcontext(cr->resume);
+
+    abort();
 }
 
-void coroutine_init(coroutine_t *cr,
-                    coroutine_cb_t cb, void *ctx,
-                    size_t stack_size) {
+static inline
+void context_make(coroutine_t *cr) {
     int rc;
     uint64_t qw;
     uint32_t dw1, dw2;
 
-    assert(cr);
-
     rc = getcontext(&cr->callee);
-    buffer_init(&cr->stack, stack_size, bp_economic);
-    cr->cb = cb;
-    cr->ctx = ctx;
-    cr->returned = false;
 
     assert(0 == rc);
     DONT_USE(rc);
 
-    cr->callee.uc_link = &cr->caller;
-    cr->callee.uc_stack.ss_size = stack_size;
+    cr->callee.uc_link = NULL;
+    cr->callee.uc_stack.ss_size = cr->stack.size;
     cr->callee.uc_stack.ss_sp = cr->stack.data;
     cr->callee.uc_stack.ss_flags = SS_ONSTACK;
     cr->callee.uc_flags = 0;
@@ -48,27 +478,164 @@ void coroutine_init(coroutine_t *cr,
     dw2 = (qw >> 0x20) & 0xffffffff;
 
     makecontext(&cr->callee, (void (*)())_caller, 2, dw1, dw2);
+
+    cr->resume = &cr->caller;
+}
+
+static inline
+void context_switch(coroutine_context_t *from, coroutine_context_t *to) {
+    swapcontext(from, to);
+}
+#endif
+
+/***************************** COROUTINE *****************************/
+/* Not inlined so that thread local address is never cached
+ * across a context switch, coroutine may be resumed by another thread.
+ */
+__attribute__((noinline))
+coroutine_t *coroutine_current(void) {
+    return current_coroutine;
+}
+
+static __attribute__((noinline))
+void current_set(coroutine_t *cr) {
+    current_coroutine = cr;
+}
+
+void coroutine_init(coroutine_t *cr,
+                    coroutine_cb_t cb, void *ctx,
+                    size_t stack_size) {
+    coroutine_init_pooled(cr, cb, ctx, stack_size, NULL);
+}
+
+void coroutine_init_pooled(coroutine_t *cr,
+                           coroutine_cb_t cb, void *ctx,
+                           size_t stack_size,
+                           coroutine_stack_pool_t *pool) {
+    assert(cr);
+
+    coroutine_stack_alloc(pool ? pool : coroutine_stack_pool_local(),
+                          &cr->stack, stack_size);
+    cr->stack_pool = pool;
+
+    coroutine_reset(cr, cb, ctx);
+}
+
+void coroutine_reset(coroutine_t *cr, coroutine_cb_t cb, void *ctx) {
+    assert(cr && cr->stack.map);
+
+    cr->cb = cb;
+    cr->ctx = ctx;
+    cr->returned = false;
+
+    cr->yielded = NULL;
+    cr->stop_requested = false;
+    cr->scope = NULL;
+
+    cr->sched = NULL;
+    atomic_init(&cr->sched_state, CR_SCHED_RUNNABLE);
+    cr->sched_request = CR_SCHED_REQ_YIELD;
+    ilist_link_init(&cr->sched_link);
+    atomic_init(&cr->refs, 1);
+    cr->timer_idx = SIZE_MAX;
+
+    memset(cr->locals, 0, sizeof(cr->locals));
+
+    context_make(cr);
 }
 
 void coroutine_deinit(coroutine_t *cr) {
     assert(cr);
 
-    buffer_deinit(&cr->stack);
+    if (cr->stack_pool)
+        coroutine_stack_release(cr->stack_pool, &cr->stack);
+    else if (!local_pool_gone)
+        coroutine_stack_release(coroutine_stack_pool_local(), &cr->stack);
+    else if (cr->stack.map)
+        stack_unmap(&cr->stack);
 }
 
 void coroutine_continue(coroutine_t *cr) {
+    coroutine_t *prev;
+
     assert(cr);
 
     if (cr->returned)
         return;
 
-    swapcontext(&cr->caller, &cr->callee);
+    prev = coroutine_current();
+    current_set(cr);
+
+    cr->resume = &cr->caller;
+    context_switch(&cr->caller, &cr->callee);
+
+    current_set(prev);
 }
 
-void coroutine_yield(coroutine_t *cr) {
+bool coroutine_yield(coroutine_t *cr) {
     assert(cr);
 
-    swapcontext(&cr->callee, &cr->caller);
+    context_switch(&cr->callee, cr->resume);
+
+    return !cr->stop_requested;
+}
+
+void coroutine_cancel(coroutine_t *cr) {
+    assert(cr);
+
+    cr->stop_requested = true;
+}
+
+bool coroutine_cancelled(const coroutine_t *cr) {
+    assert(cr);
+
+    return cr->stop_requested;
+}
+
+void coroutine_transfer(coroutine_t *from, coroutine_t *to) {
+    assert(from && to && from != to);
+    assert(!to->returned);
+    assert(!from->sched && !to->sched);
+
+    to->resume = from->resume;
+    current_set(to);
+    context_switch(&from->callee, &to->callee);
+}
+
+bool coroutine_key_create(coroutine_key_t *key) {
+    size_t idx;
+
+    assert(key);
+
+    idx = atomic_load(&keys_count);
+
+    /* counter never goes past the limit, so exhaustion is definite */
+    do {
+        if (idx >= COROUTINE_LOCALS_MAX)
+            return false;
+    } while (!atomic_compare_exchange_weak(&keys_count, &idx, idx + 1));
+
+    *key = idx;
+
+    return true;
+}
+
+void *coroutine_local_get(const coroutine_t *cr, coroutine_key_t key) {
+    assert(cr && key < COROUTINE_LOCALS_MAX);
+
+    return cr->locals[key];
+}
+
+void coroutine_local_set(coroutine_t *cr, coroutine_key_t key, void *value) {
+    assert(cr && key < COROUTINE_LOCALS_MAX);
+
+    cr->locals[key] = value;
+}
+
+size_t coroutine_stack_usage(const coroutine_t *cr) {
+    assert(cr);
+
+    return coroutine_stack_used(&cr->stack);
 }
 
 bool coroutine_returned(const coroutine_t *cr) {
@@ -76,3 +643,190 @@ bool coroutine_returned(const coroutine_t *cr) {
 
     return cr->returned;
 }
+
+/***************************** POOL *****************************/
+void coroutine_pool_init(coroutine_pool_t *pool, size_t stack_size,
+                         size_t max_cached) {
+    assert(pool);
+
+    buffer_init(&pool->cached, max_cached * sizeof(coroutine_t *),
+                bp_non_shrinkable);
+    pool->cached_count = 0;
+    pool->stack_size = stack_size;
+    pool->max_cached = max_cached;
+}
+
+void coroutine_pool_deinit(coroutine_pool_t *pool) {
+    coroutine_t **cached;
+    coroutine_t *cr;
+
+    assert(pool);
+
+    cached = pool->cached.data;
+
+    while (pool->cached_count) {
+        cr = cached[--pool->cached_count];
+
+        coroutine_deinit(cr);
+        free(cr);
+    }
+
+    buffer_deinit(&pool->cached);
+}
+
+coroutine_t *coroutine_pool_get(coroutine_pool_t *pool,
+                                coroutine_cb_t cb, void *ctx) {
+    coroutine_t *cr;
+
+    assert(pool);
+
+    if (!pool->cached_count) {
+        cr = malloc(sizeof(*cr));
+        assert(cr);
+
+        coroutine_init(cr, cb, ctx, pool->stack_size);
+
+        return cr;
+    }
+
+    cr = ((coroutine_t **)pool->cached.data)[--pool->cached_count];
+
+    coroutine_reset(cr, cb, ctx);
+
+    return cr;
+}
+
+void coroutine_pool_put(coroutine_pool_t *pool, coroutine_t *cr) {
+    assert(pool && cr);
+
+    if (pool->cached_count >= pool->max_cached) {
+        coroutine_deinit(cr);
+        free(cr);
+        return;
+    }
+
+    ((coroutine_t **)pool->cached.data)[pool->cached_count++] = cr;
+}
+
+/***************************** SCOPE *****************************/
+void coroutine_scope_init(coroutine_scope_t *scope) {
+    assert(scope);
+
+    list_init(&scope->children, true, sizeof(coroutine_t));
+    scope->cancelled = false;
+}
+
+void coroutine_scope_deinit(coroutine_scope_t *scope) {
+    assert(scope);
+
+    coroutine_scope_cancel(scope);
+    coroutine_scope_join(scope);
+
+    list_purge(&scope->children);
+}
+
+coroutine_t *coroutine_scope_spawn(coroutine_scope_t *scope,
+                                   coroutine_cb_t cb, void *ctx,
+                                   size_t stack_size) {
+    list_element_t *el;
+    coroutine_t *cr;
+
+    assert(scope);
+
+    el = list_append(&scope->children);
+    cr = el->data;
+
+    coroutine_init(cr, cb, ctx, stack_size);
+    cr->scope = scope;
+    cr->stop_requested = scope->cancelled;
+
+    return cr;
+}
+
+size_t coroutine_scope_step(coroutine_scope_t *scope) {
+    list_element_t *el;
+    coroutine_t *cr;
+
+    assert(scope);
+
+    /* children spawned meanwhile are appended and run within this step */
+    for (el = list_begin(&scope->children); el;) {
+        cr = el->data;
+
+        coroutine_continue(cr);
+
+        if (!cr->returned) {
+            el = list_next(&scope->children, el);
+            continue;
+        }
+
+        coroutine_deinit(cr);
+        el = list_remove_and_advance(&scope->children, el);
+    }
+
+    return list_size(&scope->children);
+}
+
+void coroutine_scope_join(coroutine_scope_t *scope) {
+    while (coroutine_scope_step(scope));
+}
+
+void coroutine_scope_cancel(coroutine_scope_t *scope) {
+    list_element_t *el;
+
+    assert(scope);
+
+    scope->cancelled = true;
+
+    for (el = list_begin(&scope->children); el;
+         el = list_next(&scope->children, el))
+        coroutine_cancel(el->data);
+}
+
+bool coroutine_scope_cancelled(const coroutine_scope_t *scope) {
+    assert(scope);
+
+    return scope->cancelled;
+}
+
+coroutine_scope_t *coroutine_scope(const coroutine_t *cr) {
+    assert(cr);
+
+    return cr->scope;
+}
+
+/***************************** GENERATOR *****************************/
+bool generator_yield_value(coroutine_t *cr, void *value) {
+    assert(cr);
+
+    if (cr->stop_requested)
+        return false;
+
+    cr->yielded = value;
+
+    return coroutine_yield(cr);
+}
+
+void *generator_next(coroutine_t *cr) {
+    assert(cr);
+
+    cr->yielded = NULL;
+    coroutine_continue(cr);
+
+    return cr->returned ? NULL : cr->yielded;
+}
+
+bool generator_done(const coroutine_t *cr) {
+    assert(cr);
+
+    return cr->returned;
+}
+
+void generator_stop(coroutine_t *cr) {
+    assert(cr);
+
+    cr->stop_requested = true;
+
+    while (!cr->returned)
+        coroutine_continue(cr);
+}
@@ -8,9 +8,17 @@
 void hash_map_init(hash_map_t *hm,
                    hash_function_t hasher,
                    hash_update_function_t hash_updater) {
+    hash_map_init_allocator(hm, hasher, hash_updater, NULL);
+}
+
+void hash_map_init_allocator(hash_map_t *hm,
+                             hash_function_t hasher,
+                             hash_update_function_t hash_updater,
+                             const allocator_t *allocator) {
     assert(hm);
 
-    avl_tree_init(&hm->tree, true, sizeof(hash_map_node_t));
+    avl_tree_init_allocator(&hm->tree, true, sizeof(hash_map_node_t),
+                            allocator);
 
     hm->hasher = hasher;
     hm->hash_updater = hash_updater;
@@ -25,11 +33,8 @@ void hash_map_purge(hash_map_t *hm) {
     hm->hasher = NULL;
 }
 
-size_t hash_map_size(hash_map_t *hm) {
-    assert(hm);
-
-    return hm->tree.count;
-}
+/* external definition of accessor inlined from header */
+extern inline size_t hash_map_size(hash_map_t *hm);
 
 hash_map_node_t *hash_map_add(hash_map_t *hm, hash_t h) {
     avl_tree_node_t *atn;
@@ -44,7 +49,8 @@ hash_map_node_t *hash_map_add(hash_map_t *hm, hash_t h) {
     hmn->hash = h;
     hmn->tree_node = atn;
 
-    list_init(&hmn->data_list, true, sizeof(hash_map_node_data_t));
+    list_init_allocator(&hmn->data_list, true, sizeof(hash_map_node_data_t),
+                        hm->tree.allocator);
 
     return hmn;
 }
@@ -65,7 +71,8 @@ hash_map_node_t *hash_map_add_or_get(hash_map_t *hm, hash_t h) {
         hmn->hash = h;
         hmn->tree_node = atn;
 
-        list_init(&hmn->data_list, true, sizeof(hash_map_node_data_t));
+        list_init_allocator(&hmn->data_list, true,
+                            sizeof(hash_map_node_data_t), hm->tree.allocator);
     }
 
     return hmn;
@@ -89,9 +96,14 @@ void hash_map_remove(hash_map_t *hm, hash_t h) {
 
     assert(hm);
 
-    hmn = avl_tree_remove_get_data(&hm->tree, h);
+    hmn = hash_map_get(hm, h);
+
+    if (!hmn)
+        return;
 
+    /* node payload is released along with the node */
     list_purge(&hmn->data_list);
+    avl_tree_remove(&hm->tree, h);
 }
 
 hash_map_node_t *hash_map_next(hash_map_t *hm, hash_map_node_t *hmn) {
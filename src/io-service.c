@@ -5,6 +5,7 @@
 
 #include <sys/eventfd.h>
 #include <sys/epoll.h>
+#include <sys/timerfd.h>
 
 #include <stdlib.h>
 #include <unistd.h>
@@ -12,6 +13,7 @@
 #include <stdint.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
 
 #include <assert.h>
 
@@ -146,7 +148,7 @@ void _run_unmasked(io_service_t *iosvc,
 
             if (!fd_desc->event.events) {
                 rc = epoll_ctl(iosvc->epoll_fd, EPOLL_CTL_DEL, fd, &fd_desc->event);
-                assert(rc);
+                assert(0 == rc);
                 DONT_USE(rc);
 
                 avl_tree_remove(&iosvc->fd_map, fd);
@@ -155,7 +157,8 @@ void _run_unmasked(io_service_t *iosvc,
                 memset(&fd_desc->op[op], 0, sizeof(fd_desc->op[op]));
 
                 rc = epoll_ctl(iosvc->epoll_fd, EPOLL_CTL_MOD, fd, &fd_desc->event);
-                assert(rc);
+                assert(0 == rc);
+                DONT_USE(rc);
             }
         }
 
@@ -167,6 +170,211 @@ void _run_unmasked(io_service_t *iosvc,
     }
 }
 
+/******************************* rate limiting *******************************/
+static inline
+double _timespec_diff(const struct timespec *to, const struct timespec *from) {
+    return (double)(to->tv_sec - from->tv_sec) +
+           (double)(to->tv_nsec - from->tv_nsec) / 1e9;
+}
+
+static
+void _bucket_init(iosvc_token_bucket_t *b, uint64_t rate, uint64_t burst) {
+    b->rate = rate;
+    b->burst = burst ? burst : rate;
+    b->tokens = b->burst;
+}
+
+static inline
+void _bucket_refill(iosvc_token_bucket_t *b, double elapsed) {
+    if (!b->rate)
+        return;
+
+    b->tokens += b->rate * elapsed;
+
+    if (b->tokens > b->burst)
+        b->tokens = b->burst;
+}
+
+/* seconds until bucket holds at least \c need tokens */
+static inline
+double _bucket_wait(const iosvc_token_bucket_t *b, double need) {
+    if (!b->rate || b->tokens >= need)
+        return 0.;
+
+    return (need - b->tokens) / b->rate;
+}
+
+static
+void _rate_limiter_refill(iosvc_rate_limiter_t *rl) {
+    struct timespec now;
+    double elapsed;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    elapsed = _timespec_diff(&now, &rl->last_refill);
+    rl->last_refill = now;
+
+    _bucket_refill(&rl->ops, elapsed);
+    _bucket_refill(&rl->bytes, elapsed);
+}
+
+/* seconds until one more operation may be dispatched */
+static
+double _rate_limiter_wait(const iosvc_rate_limiter_t *rl) {
+    double ops_wait = _bucket_wait(&rl->ops, 1.);
+    /* byte debt should be paid off completely */
+    double bytes_wait = _bucket_wait(&rl->bytes, 1.);
+
+    return ops_wait > bytes_wait ? ops_wait : bytes_wait;
+}
+
+static
+void _rate_limiter_arm(iosvc_rate_limiter_t *rl, double wait) {
+    struct itimerspec its;
+    int rc;
+
+    memset(&its, 0, sizeof(its));
+
+    its.it_value.tv_sec = (time_t)wait;
+    its.it_value.tv_nsec = (long)((wait - (double)its.it_value.tv_sec) * 1e9);
+
+    /* zero value disarms the timer */
+    if (!its.it_value.tv_sec && !its.it_value.tv_nsec)
+        its.it_value.tv_nsec = 1;
+
+    rc = timerfd_settime(rl->timer_fd, 0, &its, NULL);
+    assert(0 == rc);
+    DONT_USE(rc);
+
+    rl->timer_armed = true;
+}
+
+/* should be called with iosvc->mtx locked */
+static
+void _rate_limiter_suspend(io_service_t *iosvc, iosvc_fd_desc_t *fd_desc) {
+    iosvc_rate_limiter_t *rl = fd_desc->limiter;
+    list_element_t *el;
+    int rc;
+
+    rc = epoll_ctl(iosvc->epoll_fd, EPOLL_CTL_DEL, fd_desc->fd, NULL);
+    assert(0 == rc);
+    DONT_USE(rc);
+
+    fd_desc->suspended = true;
+
+    el = list_append(&rl->suspended);
+    *(int *)el->data = fd_desc->fd;
+
+    if (!rl->timer_armed)
+        _rate_limiter_arm(rl, _rate_limiter_wait(rl));
+}
+
+/* should be called with iosvc->mtx locked */
+static
+void _rate_limiter_resume_fd(io_service_t *iosvc, iosvc_fd_desc_t *fd_desc) {
+    int rc;
+
+    fd_desc->suspended = false;
+
+    if (!fd_desc->event.events)
+        return;
+
+    rc = epoll_ctl(iosvc->epoll_fd, EPOLL_CTL_ADD,
+                   fd_desc->fd, &fd_desc->event);
+    assert(0 == rc);
+    DONT_USE(rc);
+}
+
+/* should be called with iosvc->mtx locked */
+static
+void _rate_limiter_resume_all(iosvc_rate_limiter_t *rl) {
+    io_service_t *iosvc = rl->iosvc;
+    list_element_t *el;
+    avl_tree_node_t *atn_fd;
+    iosvc_fd_desc_t *fd_desc;
+
+    for (el = list_begin(&rl->suspended); el;
+         el = list_remove_and_advance(&rl->suspended, el)) {
+        atn_fd = avl_tree_get(&iosvc->fd_map, *(int *)el->data);
+
+        /* the fd might have been unwatched or recharged since */
+        if (!atn_fd)
+            continue;
+
+        fd_desc = atn_fd->data;
+
+        if (!fd_desc->suspended || fd_desc->limiter != rl)
+            continue;
+
+        _rate_limiter_resume_fd(iosvc, fd_desc);
+    }
+}
+
+/* should be called with iosvc->mtx locked */
+static
+bool _rate_limiter_admit(io_service_t *iosvc, iosvc_fd_desc_t *fd_desc) {
+    iosvc_rate_limiter_t *rl = fd_desc->limiter;
+
+    _rate_limiter_refill(rl);
+
+    if (_rate_limiter_wait(rl) > 0.) {
+        _rate_limiter_suspend(iosvc, fd_desc);
+        return false;
+    }
+
+    if (rl->ops.rate)
+        rl->ops.tokens -= 1.;
+
+    return true;
+}
+
+void _rate_limiter_timer(int fd, enum io_service_operation op,
+                         io_service_t *iosvc, void *ctx UNUSED) {
+    iosvc_rate_limiter_t *rl;
+    avl_tree_node_t *atn_fd;
+    iosvc_fd_desc_t *fd_desc;
+    uint64_t expirations;
+    ssize_t ret;
+    double wait;
+
+    assert(op == IO_SVC_OP_READ);
+
+    pthread_mutex_lock(&iosvc->mtx);
+
+    /* the limiter might have been deinitialized since the event was reported,
+     * \c ctx is only trusted while the timer is still registered */
+    atn_fd = avl_tree_get(&iosvc->fd_map, fd);
+    fd_desc = atn_fd ? atn_fd->data : NULL;
+
+    if (!fd_desc || fd_desc->op[IO_SVC_OP_READ].cb.op != _rate_limiter_timer) {
+        pthread_mutex_unlock(&iosvc->mtx);
+        return;
+    }
+
+    rl = fd_desc->op[IO_SVC_OP_READ].ctx;
+
+    /* the timer might have been rearmed since the event was reported */
+    ret = read(fd, &expirations, sizeof(expirations));
+
+    if (ret != sizeof(expirations)) {
+        assert(ret < 0 && EAGAIN == errno);
+        pthread_mutex_unlock(&iosvc->mtx);
+        return;
+    }
+
+    rl->timer_armed = false;
+
+    _rate_limiter_refill(rl);
+    wait = _rate_limiter_wait(rl);
+
+    if (wait > 0.)
+        _rate_limiter_arm(rl, wait);
+    else
+        _rate_limiter_resume_all(rl);
+
+    pthread_mutex_unlock(&iosvc->mtx);
+}
+
 void _run_events(io_service_t *iosvc,
                  struct epoll_event *events, int events_number) {
     int idx;
@@ -176,6 +384,12 @@ void _run_events(io_service_t *iosvc,
         fd_desc = events[idx].data.ptr;
 
         pthread_mutex_lock(&iosvc->mtx);
+
+        if (fd_desc->limiter && !_rate_limiter_admit(iosvc, fd_desc)) {
+            pthread_mutex_unlock(&iosvc->mtx);
+            continue;
+        }
+
         if (fd_desc->masked)
             _run_masked(iosvc, fd_desc, &events[idx]);
         else
@@ -192,7 +406,7 @@ void io_service_init(io_service_t *iosvc) {
 
     rc = pthread_mutex_init(&iosvc->mtx, NULL);
 
-    assert(rc);
+    assert(0 == rc);
     DONT_USE(rc);
 
     iosvc->event_fd = eventfd(0, EFD_CLOEXEC);
@@ -203,6 +417,8 @@ void io_service_init(io_service_t *iosvc) {
 
     iosvc->running = false;
     iosvc->allow_new_jobs = true;
+    iosvc->running_enqueued = false;
+    iosvc->rate_limiters = 0;
 
     avl_tree_init(&iosvc->fd_map, true, sizeof(iosvc_fd_desc_t));
     list_init(&iosvc->enqueued_ops, true, sizeof(iosvc_enqueued_op_t));
@@ -224,7 +440,7 @@ void io_service_deinit(io_service_t *iosvc) {
     close(iosvc->event_fd);
 
     rc = pthread_mutex_destroy(&iosvc->mtx);
-    assert(rc);
+    assert(0 == rc);
     DONT_USE(rc);
 }
 
@@ -289,6 +505,9 @@ void io_service_watch_fd(io_service_t *iosvc,
 
         fd_desc->event.data.ptr = fd_desc;
 
+        fd_desc->limiter = NULL;
+        fd_desc->suspended = false;
+
         already_watched = false;
     }
 
@@ -300,6 +519,12 @@ void io_service_watch_fd(io_service_t *iosvc,
 
     fd_desc->event.events |= OP_MAP[op];
 
+    /* events will be applied when rate limiter resumes the fd */
+    if (fd_desc->suspended) {
+        pthread_mutex_unlock(&iosvc->mtx);
+        return;
+    }
+
     if (already_watched)
         epoll_ctl_op = EPOLL_CTL_MOD;
     else
@@ -321,6 +546,7 @@ void io_service_unwatch_fd(io_service_t *iosvc,
     int rc;
     int epoll_ctl_op;
     void *ptr;
+    bool suspended;
 
     assert(iosvc);
     assert(op <= IO_SVC_OP_MAX);
@@ -345,6 +571,8 @@ void io_service_unwatch_fd(io_service_t *iosvc,
     fd_desc->op[op].ctx = NULL;
     fd_desc->event.events &= ~(OP_MAP[op]);
 
+    suspended = fd_desc->suspended;
+
     if (fd_desc->event.events) {
         epoll_ctl_op = EPOLL_CTL_MOD;
         ptr = &fd_desc->event;
@@ -356,6 +584,12 @@ void io_service_unwatch_fd(io_service_t *iosvc,
         avl_tree_remove(&iosvc->fd_map, fd);
     }
 
+    /* suspended fd is not registered with epoll */
+    if (suspended) {
+        pthread_mutex_unlock(&iosvc->mtx);
+        return;
+    }
+
     rc = epoll_ctl(iosvc->epoll_fd, epoll_ctl_op,
                    fd, ptr);
 
@@ -406,6 +640,9 @@ void io_service_watch_fd_masked(io_service_t *iosvc,
 
         fd_desc->event.data.ptr = fd_desc;
 
+        fd_desc->limiter = NULL;
+        fd_desc->suspended = false;
+
         already_watched = false;
     }
 
@@ -422,6 +659,12 @@ void io_service_watch_fd_masked(io_service_t *iosvc,
     if (fd_desc->mask & IO_SVC_OP_WRITE_MASK)
         fd_desc->event.events |= OP_MAP[IO_SVC_OP_WRITE];
 
+    /* events will be applied when rate limiter resumes the fd */
+    if (fd_desc->suspended) {
+        pthread_mutex_unlock(&iosvc->mtx);
+        return;
+    }
+
     if (already_watched)
         epoll_ctl_op = EPOLL_CTL_MOD;
     else
@@ -442,6 +685,7 @@ void io_service_unwatch_fd_masked(io_service_t *iosvc, int fd) {
     int rc;
     int epoll_ctl_op;
     void *ptr;
+    bool suspended;
 
     assert(iosvc);
 
@@ -460,13 +704,20 @@ void io_service_unwatch_fd_masked(io_service_t *iosvc, int fd) {
     fd_desc = atn_fd->data;
 
     assert(fd_desc->masked);
-    DONT_USE(fd_desc);
+
+    suspended = fd_desc->suspended;
 
     epoll_ctl_op = EPOLL_CTL_DEL;
     ptr = NULL;
 
     avl_tree_remove(&iosvc->fd_map, fd);
 
+    /* suspended fd is not registered with epoll */
+    if (suspended) {
+        pthread_mutex_unlock(&iosvc->mtx);
+        return;
+    }
+
     rc = epoll_ctl(iosvc->epoll_fd, epoll_ctl_op,
                    fd, ptr);
 
@@ -486,7 +737,12 @@ void io_service_run(io_service_t *iosvc) {
 
     pthread_mutex_lock(&iosvc->mtx);
 
-    while (iosvc->running && (iosvc->allow_new_jobs || (1 < iosvc->fd_map.count))) {
+    iosvc->running = true;
+
+    /* event fd and limiters' timers don't count as pending jobs */
+    while (iosvc->running &&
+           (iosvc->allow_new_jobs ||
+            (1 + iosvc->rate_limiters < iosvc->fd_map.count))) {
         pthread_mutex_unlock(&iosvc->mtx);
 
         rc = epoll_wait(iosvc->epoll_fd, events, ARRAY_SIZE(events), -1);
@@ -505,3 +761,138 @@ void io_service_run(io_service_t *iosvc) {
 
     pthread_mutex_unlock(&iosvc->mtx);
 }
+
+void io_service_stop(io_service_t *iosvc, bool wait_pending) {
+    assert(iosvc);
+
+    pthread_mutex_lock(&iosvc->mtx);
+
+    iosvc->allow_new_jobs = false;
+
+    if (!wait_pending)
+        iosvc->running = false;
+
+    /* wake the loop up to recheck the condition */
+    _notify(iosvc);
+
+    pthread_mutex_unlock(&iosvc->mtx);
+}
+
+void io_service_rate_limiter_init(io_service_t *iosvc,
+                                  iosvc_rate_limiter_t *rl,
+                                  uint64_t ops_per_sec, uint64_t ops_burst,
+                                  uint64_t bytes_per_sec, uint64_t bytes_burst) {
+    assert(iosvc && rl);
+
+    rl->iosvc = iosvc;
+
+    _bucket_init(&rl->ops, ops_per_sec, ops_burst);
+    _bucket_init(&rl->bytes, bytes_per_sec, bytes_burst);
+
+    clock_gettime(CLOCK_MONOTONIC, &rl->last_refill);
+
+    rl->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    assert(rl->timer_fd >= 0);
+    rl->timer_armed = false;
+
+    list_init(&rl->suspended, true, sizeof(int));
+
+    io_service_watch_fd(iosvc, rl->timer_fd, IO_SVC_OP_READ,
+                        _rate_limiter_timer, rl, false);
+
+    pthread_mutex_lock(&iosvc->mtx);
+
+    /* the service might have been stopped already */
+    if (avl_tree_get(&iosvc->fd_map, rl->timer_fd))
+        ++iosvc->rate_limiters;
+
+    pthread_mutex_unlock(&iosvc->mtx);
+}
+
+void io_service_rate_limiter_deinit(iosvc_rate_limiter_t *rl) {
+    io_service_t *iosvc;
+    avl_tree_node_t *atn_fd;
+    iosvc_fd_desc_t *fd_desc;
+    int rc;
+
+    assert(rl);
+
+    iosvc = rl->iosvc;
+
+    pthread_mutex_lock(&iosvc->mtx);
+
+    /* timer callback looks the limiter up by the registration under the
+     * mutex, hence it won't touch \c rl once the mutex is released */
+    if (avl_tree_get(&iosvc->fd_map, rl->timer_fd)) {
+        rc = epoll_ctl(iosvc->epoll_fd, EPOLL_CTL_DEL, rl->timer_fd, NULL);
+        assert(0 == rc);
+        DONT_USE(rc);
+
+        avl_tree_remove(&iosvc->fd_map, rl->timer_fd);
+        --iosvc->rate_limiters;
+    }
+
+    for (atn_fd = avl_tree_node_min(iosvc->fd_map.root); atn_fd;
+         atn_fd = avl_tree_node_next(atn_fd)) {
+        fd_desc = atn_fd->data;
+
+        if (fd_desc->limiter != rl)
+            continue;
+
+        fd_desc->limiter = NULL;
+
+        if (fd_desc->suspended)
+            _rate_limiter_resume_fd(iosvc, fd_desc);
+    }
+
+    list_purge(&rl->suspended);
+
+    close(rl->timer_fd);
+    rl->timer_fd = -1;
+
+    pthread_mutex_unlock(&iosvc->mtx);
+}
+
+void io_service_set_fd_rate_limiter(io_service_t *iosvc, int fd,
+                                    iosvc_rate_limiter_t *rl) {
+    avl_tree_node_t *atn_fd;
+    iosvc_fd_desc_t *fd_desc;
+
+    assert(iosvc);
+    assert(!rl || rl->iosvc == iosvc);
+
+    if (fd < 0)
+        return;
+
+    pthread_mutex_lock(&iosvc->mtx);
+
+    atn_fd = avl_tree_get(&iosvc->fd_map, fd);
+
+    if (!atn_fd) {
+        pthread_mutex_unlock(&iosvc->mtx);
+        return;
+    }
+
+    fd_desc = atn_fd->data;
+    fd_desc->limiter = rl;
+
+    /* the old limiter will skip the fd as it's not charged to it anymore */
+    if (fd_desc->suspended)
+        _rate_limiter_resume_fd(iosvc, fd_desc);
+
+    pthread_mutex_unlock(&iosvc->mtx);
+}
+
+void io_service_rate_limiter_consume(iosvc_rate_limiter_t *rl, size_t bytes) {
+    assert(rl);
+
+    if (!rl->bytes.rate)
+        return;
+
+    pthread_mutex_lock(&rl->iosvc->mtx);
+
+    _rate_limiter_refill(rl);
+    rl->bytes.tokens -= (double)bytes;
+
+    pthread_mutex_unlock(&rl->iosvc->mtx);
+}
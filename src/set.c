@@ -22,9 +22,13 @@ set_iterator_t fill_iterator(avl_tree_node_t *atn) {
 }
 
 void set_init(set_t *s) {
+    set_init_allocator(s, NULL);
+}
+
+void set_init_allocator(set_t *s, const allocator_t *allocator) {
     assert(s);
 
-    avl_tree_init(&s->tree, true, sizeof(set_counter_t));
+    avl_tree_init_allocator(&s->tree, true, sizeof(set_counter_t), allocator);
 }
 
 void set_purge(set_t *s) {
@@ -33,11 +37,10 @@ void set_purge(set_t *s) {
     avl_tree_purge(&s->tree);
 }
 
-size_t set_size(set_t *s) {
-    assert(s);
-
-    return s->tree.count;
-}
+/* external definitions of accessors inlined from header */
+extern inline size_t set_size(set_t *s);
+extern inline set_key_t set_get_data(avl_tree_node_t *el);
+extern inline set_counter_t set_data_count(avl_tree_node_t *el);
 
 set_counter_t set_add(set_t *s, set_key_t k) {
     bool inserted = false;
@@ -154,13 +157,3 @@ set_iterator_t set_prev(set_t *s, avl_tree_node_t *el) {
 
     return fill_iterator(atn);
 }
-
-set_counter_t set_data_count(avl_tree_node_t *el) {
-    return el ? *(set_counter_t *)el->data : 0;
-}
-
-set_key_t set_get_data(avl_tree_node_t *el) {
-    return el ? el->key : 0;
-}
-
-
@@ -0,0 +1,130 @@
+#include "slab.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <assert.h>
+
+/* fewer objects per slab make slab no better than malloc */
+#define SLAB_MIN_OBJECTS    8
+
+/* heads every slab, objects follow */
+typedef struct slab {
+    struct slab *next;
+} slab_t;
+
+#define SLAB_HEADER_SIZE    \
+    ((sizeof(slab_t) + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1))
+
+/* lives in released object */
+typedef struct slab_free_object {
+    struct slab_free_object *next;
+} slab_free_object_t;
+
+/******************************* internal funcs *******************************/
+static
+void slab_grow(slab_cache_t *c) {
+    slab_t *slab = allocator_alloc(c->allocator, c->slab_size);
+
+    assert(slab);
+
+    slab->next = c->slabs;
+    c->slabs = slab;
+    ++c->slabs_count;
+
+    /* objects are carved lazily so that a slab is touched as it's used */
+    c->carve = (char *)slab + SLAB_HEADER_SIZE;
+    c->carve_end = (char *)slab + c->slab_size;
+}
+
+/******************************* API *******************************/
+void slab_cache_init(slab_cache_t *c, size_t object_size, size_t slab_size) {
+    slab_cache_init_allocator(c, object_size, slab_size, NULL);
+}
+
+void slab_cache_init_allocator(slab_cache_t *c, size_t object_size,
+                               size_t slab_size, const allocator_t *allocator) {
+    size_t min_slab_size;
+
+    assert(c && object_size);
+
+    if (object_size < sizeof(slab_free_object_t))
+        object_size = sizeof(slab_free_object_t);
+
+    object_size = (object_size + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1);
+
+    if (!slab_size)
+        slab_size = SLAB_DEFAULT_SIZE;
+
+    min_slab_size = SLAB_HEADER_SIZE + SLAB_MIN_OBJECTS * object_size;
+
+    if (slab_size < min_slab_size)
+        slab_size = min_slab_size;
+
+    c->object_size = object_size;
+    c->slab_size = slab_size;
+    c->slabs = NULL;
+    c->slabs_count = 0;
+    c->free = NULL;
+    c->carve = c->carve_end = NULL;
+    c->count = 0;
+    c->allocator = allocator ? allocator : &allocator_default;
+}
+
+void slab_cache_deinit(slab_cache_t *c) {
+    slab_cache_reset(c);
+}
+
+void slab_cache_reset(slab_cache_t *c) {
+    slab_t *slab, *next;
+
+    assert(c);
+
+    for (slab = c->slabs; slab; slab = next) {
+        next = slab->next;
+        allocator_free(c->allocator, slab, c->slab_size);
+    }
+
+    c->slabs = NULL;
+    c->slabs_count = 0;
+    c->free = NULL;
+    c->carve = c->carve_end = NULL;
+    c->count = 0;
+}
+
+void *slab_alloc(slab_cache_t *c) {
+    slab_free_object_t *obj;
+
+    assert(c);
+
+    ++c->count;
+
+    if (c->free) {
+        obj = c->free;
+        c->free = obj->next;
+        return obj;
+    }
+
+    if (c->carve_end - c->carve < (ptrdiff_t)c->object_size)
+        slab_grow(c);
+
+    obj = (slab_free_object_t *)c->carve;
+    c->carve += c->object_size;
+
+    return obj;
+}
+
+void slab_free(slab_cache_t *c, void *obj) {
+    slab_free_object_t *fo = obj;
+
+    assert(c);
+
+    if (!fo)
+        return;
+
+    assert(c->count);
+
+    fo->next = c->free;
+    c->free = fo;
+
+    --c->count;
+}
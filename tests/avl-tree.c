@@ -1,5 +1,6 @@
 #include "avl-tree.h"
 #include "include/avl-tree.h"
+#include "include/arena.h"
 
 #include <check.h>
 
@@ -411,6 +412,107 @@ START_TEST(test_avl_tree_add_or_get_ok) {
 }
 END_TEST
 
+START_TEST(test_avl_tree_slab_ok) {
+    avl_tree_t t[2];
+    avl_tree_node_t *n;
+    slab_cache_t shared;
+    avl_tree_key_t k;
+    bool inserted;
+
+    /* owned slab */
+    avl_tree_init_slab(&t[0], true, sizeof(int), NULL);
+    ck_assert_ptr_ne(t[0].slab, NULL);
+
+    for (k = 0; k < 1000; ++k) {
+        n = avl_tree_add(&t[0], k);
+        ck_assert_ptr_eq(n->data, n + 1);
+        *(int *)n->data = (int)k;
+    }
+
+    ck_assert_int_eq(t[0].count, 1000);
+    ck_assert_uint_eq(t[0].slab->count, 1000);
+
+    for (k = 0; k < 1000; k += 2)
+        avl_tree_remove(&t[0], k);
+
+    ck_assert_int_eq(t[0].count, 500);
+    ck_assert_uint_eq(t[0].slab->count, 500);
+
+    n = avl_tree_get(&t[0], 501);
+    ck_assert_ptr_ne(n, NULL);
+    ck_assert_int_eq(*(int *)n->data, 501);
+
+    avl_tree_purge(&t[0]);
+    ck_assert_int_eq(t[0].count, 0);
+    ck_assert_ptr_eq(t[0].root, NULL);
+    ck_assert_ptr_ne(t[0].slab, NULL);
+    ck_assert_uint_eq(t[0].slab->count, 0);
+
+    /* the slab is still used after purge */
+    avl_tree_add(&t[0], 1);
+    ck_assert_uint_eq(t[0].slab->count, 1);
+
+    avl_tree_deinit(&t[0]);
+    ck_assert_int_eq(t[0].count, 0);
+    ck_assert_ptr_eq(t[0].slab, NULL);
+    ck_assert_int_eq(t[0].slab_owned, false);
+
+    /* slab shared between trees */
+    slab_cache_init(&shared, sizeof(avl_tree_node_t), 0);
+
+    avl_tree_init_slab(&t[0], false, 0, &shared);
+    avl_tree_init_slab(&t[1], false, 0, &shared);
+
+    for (k = 0; k < 10; ++k) {
+        avl_tree_add(&t[0], k);
+        n = avl_tree_add_or_get(&t[1], k, &inserted);
+        ck_assert_int_eq(inserted, true);
+        ck_assert_ptr_eq(n->data, NULL);
+    }
+
+    ck_assert_uint_eq(shared.count, 20);
+
+    avl_tree_purge(&t[0]);
+    ck_assert_uint_eq(shared.count, 10);
+
+    avl_tree_purge(&t[1]);
+    ck_assert_uint_eq(shared.count, 0);
+
+    slab_cache_deinit(&shared);
+}
+END_TEST
+
+START_TEST(test_avl_tree_arena_ok) {
+    avl_tree_t t;
+    avl_tree_node_t *n;
+    arena_t a;
+    avl_tree_key_t k;
+
+    arena_init(&a, 0);
+
+    avl_tree_init_allocator(&t, true, sizeof(int), arena_allocator(&a));
+
+    for (k = 0; k < 1000; ++k)
+        *(int *)avl_tree_add(&t, k)->data = (int)k;
+
+    for (k = 0; k < 1000; k += 3)
+        avl_tree_remove(&t, k);
+
+    n = avl_tree_get(&t, 500);
+    ck_assert_ptr_ne(n, NULL);
+    ck_assert_int_eq(*(int *)n->data, 500);
+    ck_assert_ptr_eq(avl_tree_get(&t, 501), NULL);
+
+    /* nodes go back with the arena */
+    avl_tree_purge(&t);
+    ck_assert_int_eq(t.count, 0);
+    ck_assert_ptr_eq(t.root, NULL);
+
+    arena_reset(&a);
+    arena_deinit(&a);
+}
+END_TEST
+
 Suite *avl_tree_suite(void) {
     Suite *s;
     TCase *tc;
@@ -425,6 +527,8 @@ Suite *avl_tree_suite(void) {
     tcase_add_test(tc, test_avl_tree_remove_ok);
     tcase_add_test(tc, test_avl_tree_node_next_prev_min_max_ok);
     tcase_add_test(tc, test_avl_tree_add_or_get_ok);
+    tcase_add_test(tc, test_avl_tree_slab_ok);
+    tcase_add_test(tc, test_avl_tree_arena_ok);
 
     suite_add_tcase(s, tc);
 
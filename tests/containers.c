@@ -1,7 +1,10 @@
 #include "containers.h"
 #include "include/containers.h"
+#include "include/arena.h"
 
 #include <check.h>
+#include <stdlib.h>
+#include <string.h>
 
 struct el {
     int i;
@@ -268,6 +271,327 @@ START_TEST(test_vector_begin_end_get_next_prev_ok) {
 }
 END_TEST
 
+START_TEST(test_vector_capacity_ok) {
+    vector_t v;
+    buffer_t b;
+    void *data;
+    int i;
+
+    initialize_vector(v, 0);
+
+    vector_reserve(&v, 100);
+    ck_assert_uint_ge(vector_capacity(&v), 100);
+    ck_assert_int_eq(v.count, 0);
+
+    data = v.data.data;
+
+    for (i = 0; i < 100; ++i)
+        ((struct el *)vector_append(&v))->i = i;
+
+    ck_assert_ptr_eq(v.data.data, data);
+
+    /* reservation is kept while elements are removed */
+    vector_remove_range(&v, 0, 99);
+    ck_assert_int_eq(v.count, 1);
+    ck_assert_int_eq(((struct el *)vector_get(&v, 0))->i, 99);
+    ck_assert_uint_ge(vector_capacity(&v), 100);
+    ck_assert_ptr_eq(v.data.data, data);
+
+    vector_shrink_to_fit(&v);
+    ck_assert_uint_eq(vector_capacity(&v), 1);
+    ck_assert_int_eq(((struct el *)vector_get(&v, 0))->i, 99);
+
+    /* clear keeps capacity */
+    for (i = 0; i < 50; ++i)
+        vector_append(&v);
+
+    vector_clear(&v);
+    ck_assert_int_eq(v.count, 0);
+    ck_assert_uint_ge(vector_capacity(&v), 51);
+
+    vector_append(&v);
+    ck_assert_uint_ge(vector_capacity(&v), 51);
+
+    vector_clear(&v);
+    vector_shrink_to_fit(&v);
+    ck_assert_uint_eq(vector_capacity(&v), 0);
+
+    vector_append(&v);
+    ck_assert_int_eq(v.count, 1);
+
+    vector_deinit(&v);
+
+    /* shrinkable buffer honors reservation too */
+    buffer_init(&b, 10, bp_shrinkable);
+    ck_assert_int_eq(buffer_reserve(&b, 1000), true);
+    ck_assert_uint_eq(b.real_size, 1000);
+    ck_assert_uint_eq(b.user_size, 10);
+
+    ck_assert_int_eq(buffer_realloc(&b, 1), true);
+    ck_assert_uint_eq(b.real_size, 1000);
+    ck_assert_uint_eq(b.user_size, 1);
+
+    ck_assert_int_eq(buffer_shrink_to_fit(&b), true);
+    ck_assert_uint_eq(b.real_size, 1);
+
+    buffer_deinit(&b);
+}
+END_TEST
+
+static
+bool el_is_odd(const void *el, void *ctx) {
+    ++*(int *)ctx;
+    return ((const struct el *)el)->i % 2;
+}
+
+static
+void check_vector_seq(vector_t *v, const int *expected, size_t count) {
+    size_t idx;
+
+    ck_assert_int_eq(v->count, count);
+
+    for (idx = 0; idx < count; ++idx)
+        ck_assert_int_eq(((struct el *)vector_get(v, idx))->i, expected[idx]);
+}
+
+START_TEST(test_vector_range_ok) {
+    static const int appended[] = { 0, 1, 2, 3 };
+    static const int inserted[] = { 0, 10, 11, 12, 1, 2, 3 };
+    static const int evens[] = { 0, 10, 12, 2 };
+    vector_t v;
+    struct el src[4];
+    struct el *e;
+    int i, calls = 0;
+
+    for (i = 0; i < 4; ++i) {
+        src[i].i = i;
+        src[i].j = 0;
+    }
+
+    initialize_vector(v, 0);
+
+    e = vector_append_n(&v, src, 4);
+    ck_assert_ptr_eq(e, vector_get(&v, 0));
+    check_vector_seq(&v, appended, 4);
+
+    for (i = 0; i < 3; ++i)
+        src[i].i = 10 + i;
+
+    e = vector_insert_n(&v, 1, src, 3);
+    ck_assert_ptr_eq(e, vector_get(&v, 1));
+    check_vector_seq(&v, inserted, 7);
+
+    ck_assert_int_eq(vector_remove_if(&v, el_is_odd, &calls), 3);
+    ck_assert_int_eq(calls, 7);
+    check_vector_seq(&v, evens, 4);
+
+    calls = 0;
+    ck_assert_int_eq(vector_remove_if(&v, el_is_odd, &calls), 0);
+    ck_assert_int_eq(calls, 4);
+
+    /* at the end and uninitialized */
+    e = vector_insert_n(&v, 4, NULL, 2);
+    ck_assert_ptr_eq(e, vector_get(&v, 4));
+    ck_assert_int_eq(v.count, 6);
+
+    vector_assign(&v, src, 2);
+    ck_assert_int_eq(v.count, 2);
+    ck_assert_int_eq(((struct el *)vector_get(&v, 0))->i, 10);
+    ck_assert_int_eq(((struct el *)vector_get(&v, 1))->i, 11);
+
+    vector_assign(&v, NULL, 0);
+    ck_assert_int_eq(v.count, 0);
+
+    vector_deinit(&v);
+}
+END_TEST
+
+START_TEST(test_vector_swap_remove_pop_back_ok) {
+    vector_t v;
+    struct el e;
+    size_t real_size;
+    int i;
+
+    initialize_vector(v, 0);
+
+    for (i = 0; i < 100; ++i)
+        ((struct el *)vector_append(&v))->i = i;
+
+    real_size = v.data.real_size;
+
+    /* the last one fills the hole */
+    vector_swap_remove(&v, 10);
+    ck_assert_int_eq(v.count, 99);
+    ck_assert_int_eq(((struct el *)vector_get(&v, 10))->i, 99);
+    ck_assert_int_eq(((struct el *)vector_get(&v, 98))->i, 98);
+
+    /* removal of the last one */
+    vector_swap_remove(&v, 98);
+    ck_assert_int_eq(v.count, 98);
+    ck_assert_int_eq(((struct el *)vector_get(&v, 97))->i, 97);
+
+    ck_assert_int_eq(vector_pop_back(&v, &e), true);
+    ck_assert_int_eq(e.i, 97);
+    ck_assert_int_eq(v.count, 97);
+
+    while (vector_pop_back(&v, NULL));
+
+    ck_assert_int_eq(v.count, 0);
+    ck_assert_uint_eq(v.data.user_size, 0);
+    ck_assert_uint_eq(v.data.real_size, real_size);
+    ck_assert_int_eq(vector_pop_back(&v, &e), false);
+
+    /* appending reuses the kept memory */
+    ((struct el *)vector_append(&v))->i = 1;
+    ck_assert_int_eq(((struct el *)vector_get(&v, 0))->i, 1);
+
+    vector_deinit(&v);
+}
+END_TEST
+
+START_TEST(test_small_vector_ok) {
+    SMALL_VECTOR(struct el, 4) sv;
+    int storage[2];
+    vector_t v;
+    int i;
+
+    small_vector_init(&sv);
+    ck_assert_int_eq(sv.v.count, 0);
+    ck_assert_uint_eq(vector_capacity(&sv.v), 4);
+
+    for (i = 0; i < 4; ++i)
+        ((struct el *)vector_append(&sv.v))->i = i;
+
+    ck_assert_ptr_eq(sv.v.data.data, sv.storage);
+    ck_assert_ptr_eq(vector_get(&sv.v, 3), &sv.storage[3]);
+
+    /* inline storage is kept while elements are removed */
+    vector_remove(&sv.v, 0);
+    ((struct el *)vector_prepend(&sv.v))->i = 0;
+    ck_assert_ptr_eq(sv.v.data.data, sv.storage);
+
+    vector_shrink_to_fit(&sv.v);
+    ck_assert_ptr_eq(sv.v.data.data, sv.storage);
+
+    /* spill to heap */
+    for (i = 4; i < 100; ++i)
+        ((struct el *)vector_append(&sv.v))->i = i;
+
+    ck_assert_ptr_ne(sv.v.data.data, sv.storage);
+
+    for (i = 0; i < 100; ++i)
+        ck_assert_int_eq(((struct el *)vector_get(&sv.v, i))->i, i);
+
+    vector_deinit(&sv.v);
+
+    /* storage given at init */
+    vector_init_inline(&v, sizeof(int), storage, 2);
+
+    *(int *)vector_insert(&v, 0) = 1;
+    *(int *)vector_insert(&v, 0) = 0;
+    ck_assert_ptr_eq(v.data.data, storage);
+
+    *(int *)vector_insert(&v, 1) = 5;
+    ck_assert_ptr_ne(v.data.data, storage);
+    ck_assert_int_eq(*(int *)vector_get(&v, 0), 0);
+    ck_assert_int_eq(*(int *)vector_get(&v, 1), 5);
+    ck_assert_int_eq(*(int *)vector_get(&v, 2), 1);
+
+    vector_deinit(&v);
+}
+END_TEST
+
+START_TEST(test_deque_push_pop_ok) {
+    deque_t d;
+    int i, v;
+
+    deque_init(&d, sizeof(int), 0);
+    ck_assert_uint_eq(deque_size(&d), 0);
+    ck_assert_ptr_eq(deque_front(&d), NULL);
+    ck_assert_ptr_eq(deque_back(&d), NULL);
+    ck_assert_int_eq(deque_pop_front(&d, &v), false);
+    ck_assert_int_eq(deque_pop_back(&d, &v), false);
+
+    /* 0 1 2 ... 9 */
+    for (i = 5; i < 10; ++i)
+        *(int *)deque_push_back(&d) = i;
+
+    for (i = 4; i >= 0; --i)
+        *(int *)deque_push_front(&d) = i;
+
+    ck_assert_uint_eq(deque_size(&d), 10);
+    ck_assert_int_eq(*(int *)deque_front(&d), 0);
+    ck_assert_int_eq(*(int *)deque_back(&d), 9);
+
+    for (i = 0; i < 10; ++i)
+        ck_assert_int_eq(*(int *)deque_get(&d, i), i);
+
+    ck_assert_int_eq(deque_pop_front(&d, &v), true);
+    ck_assert_int_eq(v, 0);
+    ck_assert_int_eq(deque_pop_back(&d, &v), true);
+    ck_assert_int_eq(v, 9);
+    ck_assert_int_eq(deque_pop_back(&d, NULL), true);
+
+    ck_assert_uint_eq(deque_size(&d), 7);
+    ck_assert_int_eq(*(int *)deque_front(&d), 1);
+    ck_assert_int_eq(*(int *)deque_back(&d), 7);
+
+    deque_clear(&d);
+    ck_assert_uint_eq(deque_size(&d), 0);
+    ck_assert_int_eq(deque_pop_front(&d, &v), false);
+
+    deque_deinit(&d);
+}
+END_TEST
+
+START_TEST(test_deque_wrap_grow_ok) {
+    deque_t d;
+    void *data;
+    int i, v, next = 0, expected = 0;
+
+    deque_init(&d, sizeof(int), 5);
+    ck_assert_uint_eq(d.capacity, 8);
+
+    data = d.data.data;
+
+    /* sliding window wraps around without reallocation */
+    for (i = 0; i < 100; ++i) {
+        *(int *)deque_push_back(&d) = next++;
+
+        if (deque_size(&d) > 6) {
+            ck_assert_int_eq(deque_pop_front(&d, &v), true);
+            ck_assert_int_eq(v, expected++);
+        }
+    }
+
+    ck_assert_ptr_eq(d.data.data, data);
+    ck_assert_uint_eq(d.capacity, 8);
+
+    /* growth of wrapped ring keeps the order */
+    for (i = 0; i < 30; ++i)
+        *(int *)deque_push_back(&d) = next++;
+
+    ck_assert_uint_eq(deque_size(&d), 36);
+    ck_assert_uint_eq(d.capacity, 64);
+
+    for (i = 0; i < 36; ++i)
+        ck_assert_int_eq(*(int *)deque_get(&d, i), expected + i);
+
+    /* the same from the front */
+    deque_clear(&d);
+
+    for (i = 0; i < 100; ++i)
+        *(int *)deque_push_front(&d) = i;
+
+    for (i = 0; i < 100; ++i) {
+        ck_assert_int_eq(deque_pop_back(&d, &v), true);
+        ck_assert_int_eq(v, i);
+    }
+
+    deque_deinit(&d);
+}
+END_TEST
+
 START_TEST(test_list_init_ok) {
     list_t l;
     list_element_t *init_back, *init_front;
@@ -870,6 +1194,411 @@ START_TEST(test_list_begin_end_next_prev) {
 }
 END_TEST
 
+struct inode {
+    int i;
+    ilist_link_t link;
+};
+
+#define inode_of(lnk)   ilist_entry(lnk, struct inode, link)
+
+static
+void check_ilist(ilist_t *l, const int *expected, size_t count) {
+    ilist_link_t *link;
+    size_t idx;
+
+    ck_assert_int_eq(ilist_size(l), count);
+    ck_assert_int_eq(ilist_empty(l), !count);
+
+    for (idx = 0, link = ilist_front(l); link;
+         link = ilist_next(l, link), ++idx)
+        ck_assert_int_eq(inode_of(link)->i, expected[idx]);
+
+    ck_assert_int_eq(idx, count);
+
+    for (link = ilist_back(l); link; link = ilist_prev(l, link))
+        ck_assert_int_eq(inode_of(link)->i, expected[--idx]);
+
+    ck_assert_int_eq(idx, 0);
+}
+
+START_TEST(test_ilist_insert_remove_ok) {
+    static const int all[] = { 0, 1, 2, 3, 4 };
+    static const int inner[] = { 1, 3 };
+    static const int outer[] = { 0, 1, 3, 4 };
+    ilist_t l;
+    struct inode n[5];
+    int i;
+
+    for (i = 0; i < 5; ++i) {
+        n[i].i = i;
+        ilist_link_init(&n[i].link);
+        ck_assert_int_eq(ilist_linked(&n[i].link), false);
+    }
+
+    ilist_init(&l);
+    ck_assert_ptr_eq(ilist_front(&l), NULL);
+    ck_assert_ptr_eq(ilist_back(&l), NULL);
+    ck_assert_ptr_eq(ilist_pop_front(&l), NULL);
+
+    ilist_push_back(&l, &n[2].link);
+    ilist_push_front(&l, &n[0].link);
+    ilist_push_back(&l, &n[4].link);
+    ilist_insert_after(&l, &n[0].link, &n[1].link);
+    ilist_insert_before(&l, &n[4].link, &n[3].link);
+
+    check_ilist(&l, all, 5);
+
+    ck_assert_int_eq(ilist_linked(&n[2].link), true);
+    ck_assert_ptr_eq(inode_of(&n[2].link), &n[2]);
+
+    ilist_remove(&l, &n[2].link);
+    ck_assert_int_eq(ilist_linked(&n[2].link), false);
+
+    ck_assert_ptr_eq(ilist_pop_front(&l), &n[0].link);
+    ck_assert_ptr_eq(ilist_pop_back(&l), &n[4].link);
+
+    check_ilist(&l, inner, 2);
+
+    /* nil position stands for list ends */
+    ilist_insert_after(&l, NULL, &n[0].link);
+    ilist_insert_before(&l, NULL, &n[4].link);
+
+    check_ilist(&l, outer, 4);
+}
+END_TEST
+
+START_TEST(test_ilist_splice_ok) {
+    static const int all[] = { 0, 1, 2, 3, 4 };
+    ilist_t a, b;
+    struct inode n[5];
+    int i;
+
+    ilist_init(&a);
+    ilist_init(&b);
+
+    for (i = 0; i < 5; ++i) {
+        n[i].i = i;
+        ilist_push_back(i < 2 ? &a : &b, &n[i].link);
+    }
+
+    ilist_splice(&a, &b);
+
+    check_ilist(&a, all, 5);
+    check_ilist(&b, NULL, 0);
+
+    /* into empty list */
+    ilist_splice(&b, &a);
+
+    check_ilist(&b, all, 5);
+    check_ilist(&a, NULL, 0);
+
+    /* from empty list */
+    ilist_splice(&b, &a);
+    ck_assert_int_eq(ilist_size(&b), 5);
+}
+END_TEST
+
+START_TEST(test_slab_alloc_free_ok) {
+    slab_cache_t c;
+    void *obj[100];
+    void *reused;
+    size_t idx;
+
+    slab_cache_init(&c, 3, 256);
+    ck_assert_uint_ge(c.object_size, sizeof(void *));
+    ck_assert_uint_eq(c.object_size % SLAB_ALIGN, 0);
+
+    for (idx = 0; idx < 100; ++idx) {
+        obj[idx] = slab_alloc(&c);
+        ck_assert_ptr_ne(obj[idx], NULL);
+        ck_assert_uint_eq((size_t)obj[idx] % SLAB_ALIGN, 0);
+        memset(obj[idx], (int)idx, 3);
+    }
+
+    ck_assert_uint_eq(c.count, 100);
+    ck_assert_uint_gt(c.slabs_count, 1);
+
+    for (idx = 0; idx < 100; ++idx)
+        ck_assert_int_eq(*(unsigned char *)obj[idx], idx);
+
+    /* released object is handed out first */
+    slab_free(&c, obj[42]);
+    ck_assert_uint_eq(c.count, 99);
+
+    reused = slab_alloc(&c);
+    ck_assert_ptr_eq(reused, obj[42]);
+
+    slab_cache_reset(&c);
+    ck_assert_uint_eq(c.count, 0);
+    ck_assert_uint_eq(c.slabs_count, 0);
+
+    obj[0] = slab_alloc(&c);
+    ck_assert_ptr_ne(obj[0], NULL);
+    ck_assert_uint_eq(c.slabs_count, 1);
+
+    slab_cache_deinit(&c);
+}
+END_TEST
+
+START_TEST(test_list_slab_ok) {
+    list_t l[2];
+    list_element_t *lel;
+    slab_cache_t shared;
+    struct el *e;
+    int i;
+
+    /* owned slab */
+    list_init_slab(&l[0], true, sizeof(struct el), NULL);
+    ck_assert_ptr_ne(l[0].slab, NULL);
+
+    for (i = 0; i < 1000; ++i) {
+        lel = list_append(&l[0]);
+        e = (struct el *)lel->data;
+        e->i = i;
+    }
+
+    ck_assert_int_eq(l[0].count, 1000);
+    ck_assert_uint_eq(l[0].slab->count, 1000);
+
+    for (i = 0, lel = list_begin(&l[0]); lel;
+         lel = list_next(&l[0], lel), ++i)
+        ck_assert_int_eq(((struct el *)lel->data)->i, i);
+
+    lel = list_remove_and_advance(&l[0], list_begin(&l[0]));
+    ck_assert_int_eq(((struct el *)lel->data)->i, 1);
+    ck_assert_uint_eq(l[0].slab->count, 999);
+
+    list_purge(&l[0]);
+    ck_assert_int_eq(l[0].count, 0);
+    ck_assert_ptr_ne(l[0].slab, NULL);
+    ck_assert_uint_eq(l[0].slab->count, 0);
+    ck_assert_uint_eq(l[0].slab->slabs_count, 0);
+
+    /* the slab is still used after purge */
+    lel = list_append(&l[0]);
+    ck_assert_ptr_ne(lel, NULL);
+    ck_assert_uint_eq(l[0].slab->count, 1);
+
+    list_deinit(&l[0]);
+    ck_assert_int_eq(l[0].count, 0);
+    ck_assert_ptr_eq(l[0].slab, NULL);
+    ck_assert_int_eq(l[0].slab_owned, false);
+
+    /* slab shared between lists */
+    slab_cache_init(&shared, sizeof(list_element_t), 0);
+
+    list_init_slab(&l[0], false, sizeof(struct el), &shared);
+    list_init_slab(&l[1], false, sizeof(struct el), &shared);
+
+    for (i = 0; i < 10; ++i) {
+        list_append(&l[0]);
+        list_prepend(&l[1]);
+    }
+
+    ck_assert_uint_eq(shared.count, 20);
+
+    list_purge(&l[0]);
+    ck_assert_uint_eq(shared.count, 10);
+
+    list_purge(&l[1]);
+    ck_assert_uint_eq(shared.count, 0);
+
+    slab_cache_deinit(&shared);
+}
+END_TEST
+
+struct tracking {
+    size_t allocs;
+    size_t frees;
+    size_t bytes;
+};
+
+static
+void *tracking_alloc(void *ctx, size_t size) {
+    struct tracking *t = ctx;
+
+    ++t->allocs;
+    t->bytes += size;
+
+    return malloc(size);
+}
+
+static
+void *tracking_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size) {
+    struct tracking *t = ctx;
+
+    if (!ptr)
+        ++t->allocs;
+
+    t->bytes += new_size - old_size;
+
+    return realloc(ptr, new_size);
+}
+
+static
+void tracking_free(void *ctx, void *ptr, size_t size) {
+    struct tracking *t = ctx;
+
+    ++t->frees;
+    t->bytes -= size;
+
+    free(ptr);
+}
+
+START_TEST(test_allocator_ok) {
+    struct tracking t = { 0, 0, 0 };
+    const allocator_t a = {
+        .alloc = tracking_alloc,
+        .realloc = tracking_realloc,
+        .free = tracking_free,
+        .ctx = &t
+    };
+    vector_t v;
+    list_t l;
+    int i;
+
+    vector_init_allocator(&v, sizeof(struct el), 0, &a);
+    ck_assert_ptr_eq(v.data.allocator, &a);
+
+    for (i = 0; i < 100; ++i)
+        ((struct el *)vector_append(&v))->i = i;
+
+    for (i = 0; i < 90; ++i)
+        vector_remove(&v, 0);
+
+    ck_assert_int_eq(((struct el *)vector_get(&v, 0))->i, 90);
+    ck_assert_uint_eq(t.allocs, 1);
+    ck_assert_uint_eq(t.bytes, v.data.real_size);
+
+    vector_deinit(&v);
+    ck_assert_uint_eq(t.frees, 1);
+    ck_assert_uint_eq(t.bytes, 0);
+
+    list_init_allocator(&l, true, sizeof(struct el), &a);
+
+    for (i = 0; i < 10; ++i)
+        list_append(&l);
+
+    list_remove_and_advance(&l, list_begin(&l));
+    ck_assert_uint_eq(t.allocs - t.frees, 9);
+
+    list_purge(&l);
+    ck_assert_uint_eq(t.allocs, t.frees);
+    ck_assert_uint_eq(t.bytes, 0);
+
+    /* nil stands for default allocator */
+    vector_init_allocator(&v, sizeof(struct el), 1, NULL);
+    ck_assert_ptr_eq(v.data.allocator, &allocator_default);
+    vector_deinit(&v);
+}
+END_TEST
+
+START_TEST(test_arena_alloc_ok) {
+    arena_t a;
+    char *p[4], *first;
+    size_t idx;
+
+    arena_init(&a, 1024);
+
+    first = p[0] = arena_alloc(&a, 3);
+    p[1] = arena_alloc(&a, 5);
+    ck_assert_uint_eq((size_t)p[0] % ARENA_ALIGN, 0);
+    ck_assert_uint_eq((size_t)p[1] % ARENA_ALIGN, 0);
+    ck_assert_ptr_eq(p[1], p[0] + ARENA_ALIGN);
+
+    /* the latest allocation is resized in place */
+    p[2] = arena_realloc(&a, p[1], 5, 100);
+    ck_assert_ptr_eq(p[2], p[1]);
+    p[3] = arena_alloc(&a, 1);
+    ck_assert_ptr_eq(p[3], p[1] + 112);
+
+    /* others are moved */
+    memset(p[0], 0x5a, 3);
+    p[2] = arena_realloc(&a, p[0], 3, 64);
+    ck_assert_ptr_ne(p[2], p[0]);
+    ck_assert_int_eq(p[2][2], 0x5a);
+
+    /* next blocks are chained, large allocation gets its own one */
+    for (idx = 0; idx < 100; ++idx)
+        memset(arena_alloc(&a, 100), 0, 100);
+
+    p[0] = arena_alloc(&a, 10000);
+    memset(p[0], 0, 10000);
+
+    /* blocks are reused after reset */
+    arena_reset(&a);
+    ck_assert_ptr_eq(arena_alloc(&a, 8), first);
+
+    arena_deinit(&a);
+}
+END_TEST
+
+START_TEST(test_arena_checkpoint_ok) {
+    arena_t a;
+    arena_checkpoint_t cp;
+    char *p, *q;
+    size_t idx;
+
+    arena_init(&a, 256);
+
+    /* checkpoint of empty arena */
+    cp = arena_checkpoint(&a);
+    p = arena_alloc(&a, 16);
+    arena_rollback(&a, cp);
+    ck_assert_ptr_eq(arena_alloc(&a, 16), p);
+
+    cp = arena_checkpoint(&a);
+    p = arena_alloc(&a, 16);
+
+    for (idx = 0; idx < 100; ++idx)
+        arena_alloc(&a, 64);
+
+    arena_rollback(&a, cp);
+    q = arena_alloc(&a, 16);
+    ck_assert_ptr_eq(q, p);
+
+    arena_deinit(&a);
+}
+END_TEST
+
+START_TEST(test_arena_containers_ok) {
+    arena_t a;
+    arena_checkpoint_t cp;
+    vector_t v;
+    list_t l;
+    list_element_t *lel;
+    int round, i;
+
+    arena_init(&a, 0);
+    cp = arena_checkpoint(&a);
+
+    for (round = 0; round < 3; ++round) {
+        vector_init_allocator(&v, sizeof(struct el), 0, arena_allocator(&a));
+        list_init_allocator(&l, true, sizeof(struct el), arena_allocator(&a));
+
+        for (i = 0; i < 1000; ++i) {
+            ((struct el *)vector_append(&v))->i = i;
+            ((struct el *)list_append(&l)->data)->i = i;
+        }
+
+        for (i = 0, lel = list_begin(&l); lel; lel = list_next(&l, lel), ++i) {
+            ck_assert_int_eq(((struct el *)lel->data)->i, i);
+            ck_assert_int_eq(((struct el *)vector_get(&v, i))->i, i);
+        }
+
+        list_purge(&l);
+        ck_assert_int_eq(l.count, 0);
+        ck_assert_ptr_eq(list_begin(&l), NULL);
+
+        vector_deinit(&v);
+
+        arena_rollback(&a, cp);
+    }
+
+    arena_deinit(&a);
+}
+END_TEST
+
 Suite *containers_suite(void)  {
     Suite *s;
     TCase *tc;
@@ -886,6 +1615,17 @@ Suite *containers_suite(void)  {
     tcase_add_test(tc, test_vector_append_ok);
     tcase_add_test(tc, test_vector_prepend_ok);
     tcase_add_test(tc, test_vector_begin_end_get_next_prev_ok);
+    tcase_add_test(tc, test_vector_capacity_ok);
+    tcase_add_test(tc, test_vector_range_ok);
+    tcase_add_test(tc, test_vector_swap_remove_pop_back_ok);
+    tcase_add_test(tc, test_small_vector_ok);
+
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("deque");
+
+    tcase_add_test(tc, test_deque_push_pop_ok);
+    tcase_add_test(tc, test_deque_wrap_grow_ok);
 
     suite_add_tcase(s, tc);
 
@@ -905,5 +1645,33 @@ Suite *containers_suite(void)  {
 
     suite_add_tcase(s, tc);
 
+    tc = tcase_create("intrusive list");
+
+    tcase_add_test(tc, test_ilist_insert_remove_ok);
+    tcase_add_test(tc, test_ilist_splice_ok);
+
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("slab");
+
+    tcase_add_test(tc, test_slab_alloc_free_ok);
+    tcase_add_test(tc, test_list_slab_ok);
+
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("allocator");
+
+    tcase_add_test(tc, test_allocator_ok);
+
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("arena");
+
+    tcase_add_test(tc, test_arena_alloc_ok);
+    tcase_add_test(tc, test_arena_checkpoint_ok);
+    tcase_add_test(tc, test_arena_containers_ok);
+
+    suite_add_tcase(s, tc);
+
     return s;
 }
@@ -0,0 +1,163 @@
+#include "coroutine-channel.h"
+#include "include/coroutine-channel.h"
+
+#include <check.h>
+#include <stdatomic.h>
+
+#define STACK_SIZE  (64 * 1024)
+#define PRODUCERS   4
+#define CONSUMERS   3
+#define PER_PRODUCER 2000
+
+DECLARE_COROUTINE_CHANNEL(long_channel, long)
+
+struct pipeline {
+    coroutine_channel_t ch;
+    atomic_long sum;
+    atomic_int producers_left;
+};
+
+static
+void producer_cb(coroutine_t *cr, void *ctx) {
+    struct pipeline *p = ctx;
+    long i;
+
+    for (i = 1; i <= PER_PRODUCER; ++i)
+        ck_assert_int_eq(long_channel_send(&p->ch, cr, i), true);
+
+    if (1 == atomic_fetch_sub(&p->producers_left, 1))
+        coroutine_channel_close(&p->ch);
+}
+
+static
+void consumer_cb(coroutine_t *cr, void *ctx) {
+    struct pipeline *p = ctx;
+    long v;
+
+    while (long_channel_recv(&p->ch, cr, &v))
+        atomic_fetch_add(&p->sum, v);
+}
+
+static
+void run_pipeline(size_t capacity, bool bounded) {
+    coroutine_scheduler_t s;
+    struct pipeline p;
+    int i;
+
+    if (bounded)
+        coroutine_channel_init(&p.ch, sizeof(long), capacity);
+    else
+        coroutine_channel_init_unbounded(&p.ch, sizeof(long));
+
+    atomic_init(&p.sum, 0);
+    atomic_init(&p.producers_left, PRODUCERS);
+
+    coroutine_scheduler_init(&s, 3);
+
+    for (i = 0; i < CONSUMERS; ++i)
+        coroutine_spawn(&s, consumer_cb, &p, STACK_SIZE);
+
+    for (i = 0; i < PRODUCERS; ++i)
+        coroutine_spawn(&s, producer_cb, &p, STACK_SIZE);
+
+    coroutine_scheduler_wait(&s);
+    coroutine_scheduler_deinit(&s);
+
+    ck_assert_int_eq(atomic_load(&p.sum),
+                     (long)PRODUCERS * PER_PRODUCER * (PER_PRODUCER + 1) / 2);
+    ck_assert_int_eq(coroutine_channel_size(&p.ch), 0);
+
+    coroutine_channel_deinit(&p.ch);
+}
+
+START_TEST(test_coroutine_channel_bounded_ok) {
+    run_pipeline(8, true);
+}
+END_TEST
+
+START_TEST(test_coroutine_channel_unbuffered_ok) {
+    run_pipeline(0, true);
+}
+END_TEST
+
+START_TEST(test_coroutine_channel_unbounded_ok) {
+    run_pipeline(0, false);
+}
+END_TEST
+
+START_TEST(test_coroutine_channel_try_ok) {
+    coroutine_channel_t ch;
+    long v;
+    long i;
+
+    coroutine_channel_init(&ch, sizeof(long), 3);
+
+    ck_assert_int_eq(long_channel_try_recv(&ch, &v), false);
+
+    for (i = 0; i < 3; ++i)
+        ck_assert_int_eq(long_channel_try_send(&ch, i), true);
+
+    ck_assert_int_eq(long_channel_try_send(&ch, 3), false);
+    ck_assert_int_eq(coroutine_channel_size(&ch), 3);
+
+    /* wrap the ring around */
+    ck_assert_int_eq(long_channel_try_recv(&ch, &v), true);
+    ck_assert_int_eq(v, 0);
+    ck_assert_int_eq(long_channel_try_send(&ch, 3), true);
+
+    for (i = 1; i < 4; ++i) {
+        ck_assert_int_eq(long_channel_try_recv(&ch, &v), true);
+        ck_assert_int_eq(v, i);
+    }
+
+    coroutine_channel_close(&ch);
+    ck_assert_int_eq(long_channel_try_send(&ch, 0), false);
+
+    coroutine_channel_deinit(&ch);
+}
+END_TEST
+
+START_TEST(test_coroutine_channel_unbounded_grow_ok) {
+    coroutine_channel_t ch;
+    long v;
+    long i;
+
+    coroutine_channel_init_unbounded(&ch, sizeof(long));
+
+    /* wrapped ring is unwrapped on growth */
+    for (i = 0; i < 10; ++i)
+        ck_assert_int_eq(long_channel_try_send(&ch, i), true);
+    for (i = 0; i < 10; ++i)
+        ck_assert_int_eq(long_channel_try_recv(&ch, &v), true);
+    for (i = 0; i < 100; ++i)
+        ck_assert_int_eq(long_channel_try_send(&ch, i), true);
+
+    ck_assert_int_eq(coroutine_channel_size(&ch), 100);
+
+    for (i = 0; i < 100; ++i) {
+        ck_assert_int_eq(long_channel_try_recv(&ch, &v), true);
+        ck_assert_int_eq(v, i);
+    }
+
+    coroutine_channel_deinit(&ch);
+}
+END_TEST
+
+Suite *coroutine_channel_suite(void) {
+    Suite *s;
+    TCase *tc;
+
+    s = suite_create("coroutine channel");
+
+    tc = tcase_create("channel");
+
+    tcase_add_test(tc, test_coroutine_channel_bounded_ok);
+    tcase_add_test(tc, test_coroutine_channel_unbuffered_ok);
+    tcase_add_test(tc, test_coroutine_channel_unbounded_ok);
+    tcase_add_test(tc, test_coroutine_channel_try_ok);
+    tcase_add_test(tc, test_coroutine_channel_unbounded_grow_ok);
+
+    suite_add_tcase(s, tc);
+
+    return s;
+}
@@ -0,0 +1,8 @@
+#ifndef TEST_COROUTINE_CHANNEL_H
+# define TEST_COROUTINE_CHANNEL_H
+
+# include <check.h>
+
+Suite *coroutine_channel_suite(void);
+
+#endif
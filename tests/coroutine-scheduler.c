@@ -0,0 +1,309 @@
+#include "coroutine-scheduler.h"
+#include "include/coroutine-scheduler.h"
+
+#include <check.h>
+#include <stdatomic.h>
+
+#define STACK_SIZE  (64 * 1024)
+#define COUNT       1000
+
+struct counter {
+    atomic_int value;
+    int yields;
+};
+
+static
+void count_cb(coroutine_t *cr, void *ctx) {
+    struct counter *c = ctx;
+    int i;
+
+    for (i = 0; i < c->yields; ++i)
+        coroutine_scheduler_yield(cr);
+
+    atomic_fetch_add(&c->value, 1);
+}
+
+static
+void spawner_cb(coroutine_t *cr, void *ctx) {
+    struct counter *c = ctx;
+    int i;
+
+    for (i = 0; i < COUNT; ++i)
+        coroutine_spawn(cr->sched, count_cb, c, STACK_SIZE);
+}
+
+struct ping_pong {
+    coroutine_t *peer;
+    atomic_int turn;
+    int rounds;
+    atomic_int done;
+};
+
+static
+void ponger_cb(coroutine_t *cr, void *ctx) {
+    struct ping_pong *pp = ctx;
+    int i;
+
+    for (i = 0; i < pp->rounds; ++i) {
+        while (atomic_load(&pp->turn) != 1)
+            coroutine_park(cr);
+
+        atomic_store(&pp->turn, 0);
+        coroutine_unpark(pp->peer);
+    }
+
+    atomic_fetch_add(&pp->done, 1);
+}
+
+static
+void pinger_cb(coroutine_t *cr, void *ctx) {
+    struct ping_pong *pp = ctx;
+    coroutine_t *ponger;
+    int i;
+
+    pp->peer = cr;
+    ponger = coroutine_spawn(cr->sched, ponger_cb, pp, STACK_SIZE);
+
+    for (i = 0; i < pp->rounds; ++i) {
+        atomic_store(&pp->turn, 1);
+        coroutine_unpark(ponger);
+
+        while (atomic_load(&pp->turn) != 0)
+            coroutine_park(cr);
+    }
+
+    atomic_fetch_add(&pp->done, 1);
+}
+
+#define MSEC        1000000ULL
+#define SLEEPERS    100
+
+struct sleeper {
+    atomic_int early;
+    atomic_int done;
+};
+
+static
+void sleeper_cb(coroutine_t *cr, void *ctx) {
+    struct sleeper *sl = ctx;
+    uint64_t duration = (1 + atomic_fetch_add(&sl->done, 1) % 10) * MSEC;
+    uint64_t start = coroutine_clock();
+
+    coroutine_sleep(cr, duration);
+
+    if (coroutine_clock() - start < duration)
+        atomic_fetch_add(&sl->early, 1);
+}
+
+struct timed_park {
+    coroutine_t *parked;
+    atomic_int stage;
+    bool timed_out;
+    bool unparked;
+};
+
+static
+void timed_parker_cb(coroutine_t *cr, void *ctx) {
+    struct timed_park *tp = ctx;
+
+    tp->timed_out = !coroutine_park_until(cr, coroutine_clock() + 5 * MSEC);
+
+    tp->parked = cr;
+    atomic_store(&tp->stage, 1);
+
+    /* unparked way before deadline */
+    while (atomic_load(&tp->stage) != 2)
+        if (!coroutine_park_until(cr, coroutine_clock() + 10000 * MSEC))
+            return;
+
+    tp->unparked = true;
+}
+
+static
+void timed_unparker_cb(coroutine_t *cr, void *ctx) {
+    struct timed_park *tp = ctx;
+
+    while (atomic_load(&tp->stage) != 1)
+        coroutine_sleep(cr, MSEC);
+
+    atomic_store(&tp->stage, 2);
+    coroutine_unpark(tp->parked);
+}
+
+struct early_unpark {
+    bool unparked;
+    bool woken;
+};
+
+static
+void early_parker_cb(coroutine_t *cr, void *ctx) {
+    struct early_unpark *eu = ctx;
+
+    /* was unparked while still queued */
+    eu->woken = coroutine_park_until(cr, coroutine_clock() + 1000 * MSEC);
+}
+
+static
+void early_unparker_cb(coroutine_t *cr, void *ctx) {
+    struct early_unpark *eu = ctx;
+    coroutine_t *parker;
+
+    /* the only worker is busy with us, so parker stays in queue */
+    parker = coroutine_spawn(cr->sched, early_parker_cb, eu, STACK_SIZE);
+
+    ck_assert_int_eq(atomic_load(&parker->sched_state), CR_SCHED_RUNNABLE);
+    coroutine_unpark(parker);
+    ck_assert_int_eq(atomic_load(&parker->sched_state), CR_SCHED_NOTIFIED);
+
+    eu->unparked = true;
+}
+
+START_TEST(test_coroutine_scheduler_spawn_ok) {
+    coroutine_scheduler_t s;
+    struct counter c = { .yields = 3 };
+    int i;
+
+    atomic_init(&c.value, 0);
+
+    coroutine_scheduler_init(&s, 4);
+
+    ck_assert_int_eq(s.workers_count, 4);
+
+    for (i = 0; i < COUNT; ++i)
+        coroutine_spawn(&s, count_cb, &c, STACK_SIZE);
+
+    coroutine_scheduler_wait(&s);
+
+    ck_assert_int_eq(atomic_load(&c.value), COUNT);
+    ck_assert_int_eq(atomic_load(&s.live), 0);
+
+    coroutine_scheduler_deinit(&s);
+}
+END_TEST
+
+START_TEST(test_coroutine_scheduler_spawn_from_worker_ok) {
+    coroutine_scheduler_t s;
+    struct counter c = { .yields = 1 };
+
+    atomic_init(&c.value, 0);
+
+    coroutine_scheduler_init(&s, 3);
+
+    coroutine_spawn(&s, spawner_cb, &c, STACK_SIZE);
+
+    coroutine_scheduler_wait(&s);
+
+    ck_assert_int_eq(atomic_load(&c.value), COUNT);
+
+    coroutine_scheduler_deinit(&s);
+}
+END_TEST
+
+START_TEST(test_coroutine_scheduler_park_unpark_ok) {
+    coroutine_scheduler_t s;
+    struct ping_pong pp = { .rounds = 10000 };
+
+    atomic_init(&pp.turn, 0);
+    atomic_init(&pp.done, 0);
+
+    coroutine_scheduler_init(&s, 2);
+
+    coroutine_spawn(&s, pinger_cb, &pp, STACK_SIZE);
+
+    coroutine_scheduler_wait(&s);
+
+    ck_assert_int_eq(atomic_load(&pp.done), 2);
+
+    coroutine_scheduler_deinit(&s);
+}
+END_TEST
+
+START_TEST(test_coroutine_scheduler_sleep_ok) {
+    coroutine_scheduler_t s;
+    struct sleeper sl;
+    uint64_t start;
+    int i;
+
+    atomic_init(&sl.early, 0);
+    atomic_init(&sl.done, 0);
+
+    coroutine_scheduler_init(&s, 2);
+
+    start = coroutine_clock();
+
+    for (i = 0; i < SLEEPERS; ++i)
+        coroutine_spawn(&s, sleeper_cb, &sl, STACK_SIZE);
+
+    coroutine_scheduler_wait(&s);
+
+    /* sleepers don't hold worker threads */
+    ck_assert_uint_lt(coroutine_clock() - start, SLEEPERS * MSEC);
+    ck_assert_int_eq(atomic_load(&sl.early), 0);
+    ck_assert_int_eq(s.timers.count, 0);
+
+    coroutine_scheduler_deinit(&s);
+}
+END_TEST
+
+START_TEST(test_coroutine_scheduler_park_until_ok) {
+    coroutine_scheduler_t s;
+    struct timed_park tp = { .timed_out = false, .unparked = false };
+
+    atomic_init(&tp.stage, 0);
+
+    coroutine_scheduler_init(&s, 2);
+
+    coroutine_spawn(&s, timed_parker_cb, &tp, STACK_SIZE);
+    coroutine_spawn(&s, timed_unparker_cb, &tp, STACK_SIZE);
+
+    coroutine_scheduler_wait(&s);
+
+    ck_assert_int_eq(tp.timed_out, true);
+    ck_assert_int_eq(tp.unparked, true);
+    ck_assert_int_eq(s.timers.count, 0);
+
+    coroutine_scheduler_deinit(&s);
+}
+END_TEST
+
+START_TEST(test_coroutine_scheduler_unpark_queued_ok) {
+    coroutine_scheduler_t s;
+    struct early_unpark eu = { .unparked = false, .woken = false };
+    uint64_t start;
+
+    coroutine_scheduler_init(&s, 1);
+
+    start = coroutine_clock();
+
+    coroutine_spawn(&s, early_unparker_cb, &eu, STACK_SIZE);
+
+    coroutine_scheduler_wait(&s);
+
+    ck_assert_int_eq(eu.unparked, true);
+    ck_assert_int_eq(eu.woken, true);
+    ck_assert_uint_lt(coroutine_clock() - start, 500 * MSEC);
+    ck_assert_int_eq(s.timers.count, 0);
+
+    coroutine_scheduler_deinit(&s);
+}
+END_TEST
+
+Suite *coroutine_scheduler_suite(void) {
+    Suite *s;
+    TCase *tc;
+
+    s = suite_create("coroutine scheduler");
+
+    tc = tcase_create("scheduler");
+
+    tcase_add_test(tc, test_coroutine_scheduler_spawn_ok);
+    tcase_add_test(tc, test_coroutine_scheduler_spawn_from_worker_ok);
+    tcase_add_test(tc, test_coroutine_scheduler_park_unpark_ok);
+    tcase_add_test(tc, test_coroutine_scheduler_sleep_ok);
+    tcase_add_test(tc, test_coroutine_scheduler_park_until_ok);
+    tcase_add_test(tc, test_coroutine_scheduler_unpark_queued_ok);
+
+    suite_add_tcase(s, tc);
+
+    return s;
+}
@@ -0,0 +1,8 @@
+#ifndef TEST_COROUTINE_SCHEDULER_H
+# define TEST_COROUTINE_SCHEDULER_H
+
+# include <check.h>
+
+Suite *coroutine_scheduler_suite(void);
+
+#endif
@@ -0,0 +1,365 @@
+#include "coroutine-sync.h"
+#include "include/coroutine-sync.h"
+
+#include <check.h>
+#include <stdatomic.h>
+
+#define STACK_SIZE  (64 * 1024)
+#define COUNT       200
+#define ROUNDS      50
+
+struct shared {
+    coroutine_mutex_t mtx;
+    coroutine_sem_t sem;
+    coroutine_cond_t cond;
+    coroutine_wait_group_t wg;
+
+    /* protected by mtx */
+    long value;
+    int ready;
+
+    atomic_int inside;
+    atomic_int max_inside;
+    atomic_int done;
+};
+
+static
+void mutex_cb(coroutine_t *cr, void *ctx) {
+    struct shared *sh = ctx;
+    long v;
+    int i;
+
+    for (i = 0; i < ROUNDS; ++i) {
+        coroutine_mutex_lock(&sh->mtx, cr);
+
+        /* let others run while holding the mutex */
+        v = sh->value;
+        coroutine_scheduler_yield(cr);
+        sh->value = v + 1;
+
+        coroutine_mutex_unlock(&sh->mtx);
+    }
+}
+
+static
+void sem_cb(coroutine_t *cr, void *ctx) {
+    struct shared *sh = ctx;
+    int inside, max;
+
+    coroutine_sem_wait(&sh->sem, cr);
+
+    inside = atomic_fetch_add(&sh->inside, 1) + 1;
+    max = atomic_load(&sh->max_inside);
+
+    while (inside > max &&
+           !atomic_compare_exchange_weak(&sh->max_inside, &max, inside));
+
+    coroutine_scheduler_yield(cr);
+
+    atomic_fetch_sub(&sh->inside, 1);
+    atomic_fetch_add(&sh->done, 1);
+
+    coroutine_sem_post(&sh->sem);
+}
+
+static
+void cond_waiter_cb(coroutine_t *cr, void *ctx) {
+    struct shared *sh = ctx;
+
+    coroutine_mutex_lock(&sh->mtx, cr);
+
+    while (!sh->ready)
+        coroutine_cond_wait(&sh->cond, &sh->mtx, cr);
+
+    ++sh->value;
+
+    coroutine_mutex_unlock(&sh->mtx);
+}
+
+static
+void cond_signaller_cb(coroutine_t *cr, void *ctx) {
+    struct shared *sh = ctx;
+    int i;
+
+    for (i = 0; i < 10; ++i)
+        coroutine_scheduler_yield(cr);
+
+    coroutine_mutex_lock(&sh->mtx, cr);
+    sh->ready = 1;
+    coroutine_cond_broadcast(&sh->cond);
+    coroutine_mutex_unlock(&sh->mtx);
+}
+
+static
+void wg_worker_cb(coroutine_t *cr, void *ctx) {
+    struct shared *sh = ctx;
+
+    coroutine_scheduler_yield(cr);
+
+    atomic_fetch_add(&sh->done, 1);
+    coroutine_wait_group_done(&sh->wg);
+}
+
+static
+void wg_parent_cb(coroutine_t *cr, void *ctx) {
+    struct shared *sh = ctx;
+    int i;
+
+    coroutine_wait_group_add(&sh->wg, COUNT);
+
+    for (i = 0; i < COUNT; ++i)
+        coroutine_spawn(cr->sched, wg_worker_cb, sh, STACK_SIZE);
+
+    coroutine_wait_group_wait(&sh->wg, cr);
+
+    /* every child is done by now */
+    sh->value = atomic_load(&sh->done);
+}
+
+#define USEC        1000ULL
+#define MSEC        1000000ULL
+
+static
+void sem_timed_cb(coroutine_t *cr, void *ctx) {
+    struct shared *sh = ctx;
+
+    if (coroutine_sem_wait_for(&sh->sem, cr, 200 * USEC))
+        atomic_fetch_add(&sh->done, 1);
+    else
+        atomic_fetch_add(&sh->inside, 1);
+}
+
+static
+void sem_poster_cb(coroutine_t *cr, void *ctx) {
+    struct shared *sh = ctx;
+    int i;
+
+    for (i = 0; i < COUNT / 2; ++i) {
+        coroutine_sem_post(&sh->sem);
+
+        if (!(i % 10))
+            coroutine_sleep(cr, 50 * USEC);
+    }
+}
+
+static
+void mutex_holder_cb(coroutine_t *cr, void *ctx) {
+    struct shared *sh = ctx;
+
+    coroutine_mutex_lock(&sh->mtx, cr);
+    atomic_store(&sh->max_inside, 1);
+
+    coroutine_sleep(cr, 20 * MSEC);
+
+    coroutine_mutex_unlock(&sh->mtx);
+}
+
+static
+void mutex_timed_cb(coroutine_t *cr, void *ctx) {
+    struct shared *sh = ctx;
+
+    while (!atomic_load(&sh->max_inside))
+        coroutine_scheduler_yield(cr);
+
+    /* holder keeps it way longer */
+    if (!coroutine_mutex_lock_for(&sh->mtx, cr, MSEC))
+        atomic_fetch_add(&sh->inside, 1);
+    else
+        coroutine_mutex_unlock(&sh->mtx);
+
+    /* and releases it eventually */
+    if (coroutine_mutex_lock_for(&sh->mtx, cr, 1000 * MSEC)) {
+        atomic_fetch_add(&sh->done, 1);
+        coroutine_mutex_unlock(&sh->mtx);
+    }
+
+    /* nobody signals */
+    coroutine_mutex_lock(&sh->mtx, cr);
+
+    if (!coroutine_cond_wait_for(&sh->cond, &sh->mtx, cr, MSEC))
+        ++sh->value;
+
+    coroutine_mutex_unlock(&sh->mtx);
+}
+
+static
+void shared_init(struct shared *sh, size_t sem_count) {
+    coroutine_mutex_init(&sh->mtx);
+    coroutine_sem_init(&sh->sem, sem_count);
+    coroutine_cond_init(&sh->cond);
+    coroutine_wait_group_init(&sh->wg);
+
+    sh->value = 0;
+    sh->ready = 0;
+
+    atomic_init(&sh->inside, 0);
+    atomic_init(&sh->max_inside, 0);
+    atomic_init(&sh->done, 0);
+}
+
+static
+void shared_deinit(struct shared *sh) {
+    coroutine_wait_group_deinit(&sh->wg);
+    coroutine_cond_deinit(&sh->cond);
+    coroutine_sem_deinit(&sh->sem);
+    coroutine_mutex_deinit(&sh->mtx);
+}
+
+START_TEST(test_coroutine_mutex_ok) {
+    coroutine_scheduler_t s;
+    struct shared sh;
+    int i;
+
+    shared_init(&sh, 0);
+    coroutine_scheduler_init(&s, 4);
+
+    for (i = 0; i < COUNT; ++i)
+        coroutine_spawn(&s, mutex_cb, &sh, STACK_SIZE);
+
+    coroutine_scheduler_wait(&s);
+    coroutine_scheduler_deinit(&s);
+
+    ck_assert_int_eq(sh.value, COUNT * ROUNDS);
+    ck_assert_int_eq(coroutine_mutex_trylock(&sh.mtx), true);
+    ck_assert_int_eq(coroutine_mutex_trylock(&sh.mtx), false);
+    coroutine_mutex_unlock(&sh.mtx);
+
+    shared_deinit(&sh);
+}
+END_TEST
+
+START_TEST(test_coroutine_sem_ok) {
+    coroutine_scheduler_t s;
+    struct shared sh;
+    int i;
+
+    shared_init(&sh, 3);
+    coroutine_scheduler_init(&s, 4);
+
+    for (i = 0; i < COUNT; ++i)
+        coroutine_spawn(&s, sem_cb, &sh, STACK_SIZE);
+
+    coroutine_scheduler_wait(&s);
+    coroutine_scheduler_deinit(&s);
+
+    ck_assert_int_eq(atomic_load(&sh.done), COUNT);
+    ck_assert_int_le(atomic_load(&sh.max_inside), 3);
+    ck_assert_int_eq(sh.sem.count, 3);
+
+    ck_assert_int_eq(coroutine_sem_trywait(&sh.sem), true);
+    ck_assert_int_eq(sh.sem.count, 2);
+
+    shared_deinit(&sh);
+}
+END_TEST
+
+START_TEST(test_coroutine_cond_ok) {
+    coroutine_scheduler_t s;
+    struct shared sh;
+    int i;
+
+    shared_init(&sh, 0);
+    coroutine_scheduler_init(&s, 4);
+
+    for (i = 0; i < COUNT; ++i)
+        coroutine_spawn(&s, cond_waiter_cb, &sh, STACK_SIZE);
+
+    coroutine_spawn(&s, cond_signaller_cb, &sh, STACK_SIZE);
+
+    coroutine_scheduler_wait(&s);
+    coroutine_scheduler_deinit(&s);
+
+    ck_assert_int_eq(sh.value, COUNT);
+
+    shared_deinit(&sh);
+}
+END_TEST
+
+START_TEST(test_coroutine_wait_group_ok) {
+    coroutine_scheduler_t s;
+    struct shared sh;
+
+    shared_init(&sh, 0);
+    coroutine_scheduler_init(&s, 4);
+
+    coroutine_spawn(&s, wg_parent_cb, &sh, STACK_SIZE);
+
+    coroutine_scheduler_wait(&s);
+    coroutine_scheduler_deinit(&s);
+
+    ck_assert_int_eq(sh.value, COUNT);
+    ck_assert_int_eq(sh.wg.count, 0);
+
+    shared_deinit(&sh);
+}
+END_TEST
+
+START_TEST(test_coroutine_sem_timed_ok) {
+    coroutine_scheduler_t s;
+    struct shared sh;
+    int i;
+
+    shared_init(&sh, 0);
+    coroutine_scheduler_init(&s, 4);
+
+    for (i = 0; i < COUNT; ++i)
+        coroutine_spawn(&s, sem_timed_cb, &sh, STACK_SIZE);
+
+    coroutine_spawn(&s, sem_poster_cb, &sh, STACK_SIZE);
+
+    coroutine_scheduler_wait(&s);
+    coroutine_scheduler_deinit(&s);
+
+    /* every permit is either taken or left */
+    ck_assert_int_eq(atomic_load(&sh.done) + atomic_load(&sh.inside), COUNT);
+    ck_assert_int_eq(atomic_load(&sh.done) + sh.sem.count, COUNT / 2);
+    ck_assert_int_eq(coroutine_wait_queue_empty(&sh.sem.waiters), true);
+
+    shared_deinit(&sh);
+}
+END_TEST
+
+START_TEST(test_coroutine_mutex_cond_timed_ok) {
+    coroutine_scheduler_t s;
+    struct shared sh;
+    int i;
+
+    shared_init(&sh, 0);
+    coroutine_scheduler_init(&s, 4);
+
+    coroutine_spawn(&s, mutex_holder_cb, &sh, STACK_SIZE);
+
+    for (i = 0; i < 10; ++i)
+        coroutine_spawn(&s, mutex_timed_cb, &sh, STACK_SIZE);
+
+    coroutine_scheduler_wait(&s);
+    coroutine_scheduler_deinit(&s);
+
+    ck_assert_int_eq(atomic_load(&sh.inside), 10);
+    ck_assert_int_eq(atomic_load(&sh.done), 10);
+    ck_assert_int_eq(sh.value, 10);
+    ck_assert_int_eq(sh.mtx.locked, false);
+
+    shared_deinit(&sh);
+}
+END_TEST
+
+Suite *coroutine_sync_suite(void) {
+    Suite *s;
+    TCase *tc;
+
+    s = suite_create("coroutine sync");
+
+    tc = tcase_create("sync");
+
+    tcase_add_test(tc, test_coroutine_mutex_ok);
+    tcase_add_test(tc, test_coroutine_sem_ok);
+    tcase_add_test(tc, test_coroutine_cond_ok);
+    tcase_add_test(tc, test_coroutine_wait_group_ok);
+    tcase_add_test(tc, test_coroutine_sem_timed_ok);
+    tcase_add_test(tc, test_coroutine_mutex_cond_timed_ok);
+
+    suite_add_tcase(s, tc);
+
+    return s;
+}
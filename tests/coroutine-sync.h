@@ -0,0 +1,8 @@
+#ifndef TEST_COROUTINE_SYNC_H
+# define TEST_COROUTINE_SYNC_H
+
+# include <check.h>
+
+Suite *coroutine_sync_suite(void);
+
+#endif
@@ -0,0 +1,734 @@
+#include "coroutine.h"
+#include "include/coroutine.h"
+
+#include <check.h>
+#include <pthread.h>
+#include <string.h>
+
+#define STACK_SIZE  (64 * 1024)
+
+struct trace {
+    int steps[16];
+    int count;
+};
+
+static
+void trace_cb(coroutine_t *cr, void *ctx) {
+    struct trace *t = ctx;
+    int i;
+
+    for (i = 0; i < 3; ++i) {
+        t->steps[t->count++] = i;
+        coroutine_yield(cr);
+    }
+}
+
+static
+void fpu_cb(coroutine_t *cr, void *ctx) {
+    double *d = ctx;
+    double acc = 1.5;
+
+    coroutine_yield(cr);
+
+    acc *= *d;
+    *d = acc;
+}
+
+static
+void nested_inner_cb(coroutine_t *cr, void *ctx) {
+    struct trace *t = ctx;
+
+    t->steps[t->count++] = 10;
+    coroutine_yield(cr);
+    t->steps[t->count++] = 11;
+}
+
+static
+void nested_outer_cb(coroutine_t *cr, void *ctx) {
+    struct trace *t = ctx;
+    coroutine_t inner;
+
+    coroutine_init(&inner, nested_inner_cb, t, STACK_SIZE);
+
+    t->steps[t->count++] = 0;
+    coroutine_continue(&inner);
+    coroutine_yield(cr);
+
+    t->steps[t->count++] = 1;
+    coroutine_continue(&inner);
+
+    coroutine_deinit(&inner);
+}
+
+struct relay {
+    coroutine_t cr[2];
+    struct trace t;
+};
+
+static
+void relay_first_cb(coroutine_t *cr, void *ctx) {
+    struct relay *r = ctx;
+
+    r->t.steps[r->t.count++] = 0;
+    coroutine_transfer(cr, &r->cr[1]);
+    r->t.steps[r->t.count++] = 2;
+    coroutine_yield(cr);
+    r->t.steps[r->t.count++] = 4;
+    coroutine_transfer(cr, &r->cr[1]);
+}
+
+static
+void relay_second_cb(coroutine_t *cr, void *ctx) {
+    struct relay *r = ctx;
+
+    r->t.steps[r->t.count++] = 1;
+    coroutine_transfer(cr, &r->cr[0]);
+    r->t.steps[r->t.count++] = 3;
+    coroutine_yield(cr);
+    r->t.steps[r->t.count++] = 5;
+}
+
+struct locals {
+    coroutine_key_t key;
+    coroutine_t *outer;
+    coroutine_t *seen[4];
+    void *values[4];
+};
+
+static
+void locals_inner_cb(coroutine_t *cr, void *ctx) {
+    struct locals *l = ctx;
+
+    l->seen[1] = coroutine_current();
+    l->values[1] = coroutine_local_get(coroutine_current(), l->key);
+    coroutine_local_set(cr, l->key, &l->values[1]);
+}
+
+static
+void locals_outer_cb(coroutine_t *cr, void *ctx) {
+    struct locals *l = ctx;
+    coroutine_t inner;
+
+    coroutine_local_set(coroutine_current(), l->key, l);
+    l->seen[0] = coroutine_current();
+
+    coroutine_yield(cr);
+
+    coroutine_init(&inner, locals_inner_cb, l, STACK_SIZE);
+    coroutine_continue(&inner);
+
+    l->seen[2] = coroutine_current();
+    l->values[2] = coroutine_local_get(cr, l->key);
+    l->values[3] = coroutine_local_get(&inner, l->key);
+
+    coroutine_deinit(&inner);
+}
+
+struct worker {
+    int steps;
+    int fail_at;
+    int done;
+    bool cancelled;
+};
+
+static
+void worker_cb(coroutine_t *cr, void *ctx) {
+    struct worker *w = ctx;
+
+    for (w->done = 0; w->done < w->steps; ++w->done) {
+        if (w->done == w->fail_at) {
+            coroutine_scope_cancel(coroutine_scope(cr));
+            return;
+        }
+
+        if (!coroutine_yield(cr)) {
+            w->cancelled = true;
+            return;
+        }
+    }
+}
+
+struct range {
+    int from;
+    int to;
+    int last;
+    bool cleaned_up;
+};
+
+static
+void range_cb(coroutine_t *cr, void *ctx) {
+    struct range *r = ctx;
+    int i;
+
+    for (i = r->from; i < r->to; ++i) {
+        r->last = i;
+
+        if (!generator_yield_value(cr, &i))
+            break;
+    }
+
+    r->cleaned_up = true;
+}
+
+START_TEST(test_coroutine_continue_yield_ok) {
+    coroutine_t cr;
+    struct trace t = { .count = 0 };
+    int i;
+
+    coroutine_init(&cr, trace_cb, &t, STACK_SIZE);
+
+    ck_assert_int_eq(coroutine_returned(&cr), false);
+
+    for (i = 0; i < 3; ++i) {
+        coroutine_continue(&cr);
+        ck_assert_int_eq(t.count, i + 1);
+        ck_assert_int_eq(t.steps[i], i);
+        ck_assert_int_eq(coroutine_returned(&cr), false);
+    }
+
+    coroutine_continue(&cr);
+    ck_assert_int_eq(coroutine_returned(&cr), true);
+
+    /* continuing returned coroutine is a no-op */
+    coroutine_continue(&cr);
+    ck_assert_int_eq(t.count, 3);
+
+    coroutine_deinit(&cr);
+}
+END_TEST
+
+START_TEST(test_coroutine_fpu_ok) {
+    coroutine_t cr;
+    double d = 3.;
+
+    coroutine_init(&cr, fpu_cb, &d, STACK_SIZE);
+
+    coroutine_continue(&cr);
+    d *= 2.;
+    coroutine_continue(&cr);
+
+    ck_assert_int_eq(coroutine_returned(&cr), true);
+    ck_assert_int_eq((int)d, 9);
+
+    coroutine_deinit(&cr);
+}
+END_TEST
+
+START_TEST(test_coroutine_nested_ok) {
+    coroutine_t cr;
+    struct trace t = { .count = 0 };
+
+    coroutine_init(&cr, nested_outer_cb, &t, STACK_SIZE);
+
+    coroutine_continue(&cr);
+    ck_assert_int_eq(t.count, 2);
+    ck_assert_int_eq(t.steps[0], 0);
+    ck_assert_int_eq(t.steps[1], 10);
+
+    coroutine_continue(&cr);
+    ck_assert_int_eq(coroutine_returned(&cr), true);
+    ck_assert_int_eq(t.count, 4);
+    ck_assert_int_eq(t.steps[2], 1);
+    ck_assert_int_eq(t.steps[3], 11);
+
+    coroutine_deinit(&cr);
+}
+END_TEST
+
+START_TEST(test_coroutine_transfer_ok) {
+    struct relay r = { .t.count = 0 };
+    int i;
+
+    coroutine_init(&r.cr[0], relay_first_cb, &r, STACK_SIZE);
+    coroutine_init(&r.cr[1], relay_second_cb, &r, STACK_SIZE);
+
+    /* first -> second -> first -> back here */
+    coroutine_continue(&r.cr[0]);
+    ck_assert_int_eq(r.t.count, 3);
+
+    /* second is resumed by hand, yields back here */
+    coroutine_continue(&r.cr[1]);
+    ck_assert_int_eq(r.t.count, 4);
+
+    /* first -> second which returns here */
+    coroutine_continue(&r.cr[0]);
+    ck_assert_int_eq(r.t.count, 6);
+    ck_assert_int_eq(coroutine_returned(&r.cr[1]), true);
+    ck_assert_int_eq(coroutine_returned(&r.cr[0]), false);
+
+    for (i = 0; i < r.t.count; ++i)
+        ck_assert_int_eq(r.t.steps[i], i);
+
+    coroutine_deinit(&r.cr[0]);
+    coroutine_deinit(&r.cr[1]);
+}
+END_TEST
+
+START_TEST(test_coroutine_locals_ok) {
+    struct locals l;
+    coroutine_t cr;
+    coroutine_key_t other;
+
+    memset(&l, 0, sizeof(l));
+
+    ck_assert_int_eq(coroutine_key_create(&l.key), true);
+    ck_assert_int_eq(coroutine_key_create(&other), true);
+    ck_assert_int_ne(l.key, other);
+
+    ck_assert_ptr_eq(coroutine_current(), NULL);
+
+    coroutine_init(&cr, locals_outer_cb, &l, STACK_SIZE);
+    ck_assert_ptr_eq(coroutine_local_get(&cr, l.key), NULL);
+
+    coroutine_continue(&cr);
+    ck_assert_ptr_eq(coroutine_current(), NULL);
+    ck_assert_ptr_eq(l.seen[0], &cr);
+    ck_assert_ptr_eq(coroutine_local_get(&cr, l.key), &l);
+    ck_assert_ptr_eq(coroutine_local_get(&cr, other), NULL);
+
+    coroutine_continue(&cr);
+    ck_assert_int_eq(coroutine_returned(&cr), true);
+    ck_assert_ptr_eq(coroutine_current(), NULL);
+
+    /* inner coroutine has its own slots */
+    ck_assert_ptr_ne(l.seen[1], NULL);
+    ck_assert_ptr_ne(l.seen[1], &cr);
+    ck_assert_ptr_eq(l.values[1], NULL);
+    ck_assert_ptr_eq(l.seen[2], &cr);
+    ck_assert_ptr_eq(l.values[2], &l);
+    ck_assert_ptr_eq(l.values[3], &l.values[1]);
+
+    coroutine_deinit(&cr);
+}
+END_TEST
+
+START_TEST(test_coroutine_scope_join_ok) {
+    coroutine_scope_t scope;
+    struct worker w[3] = {
+        { .steps = 1, .fail_at = -1 },
+        { .steps = 3, .fail_at = -1 },
+        { .steps = 5, .fail_at = -1 }
+    };
+    coroutine_t *cr;
+    size_t i;
+
+    coroutine_scope_init(&scope);
+
+    for (i = 0; i < 3; ++i) {
+        cr = coroutine_scope_spawn(&scope, worker_cb, &w[i], STACK_SIZE);
+        ck_assert_ptr_eq(coroutine_scope(cr), &scope);
+    }
+
+    ck_assert_int_eq(coroutine_scope_step(&scope), 3);
+    ck_assert_int_eq(coroutine_scope_step(&scope), 2);
+
+    coroutine_scope_join(&scope);
+    ck_assert_int_eq(list_size(&scope.children), 0);
+
+    for (i = 0; i < 3; ++i) {
+        ck_assert_int_eq(w[i].done, w[i].steps);
+        ck_assert_int_eq(w[i].cancelled, false);
+    }
+
+    ck_assert_int_eq(coroutine_scope_cancelled(&scope), false);
+
+    coroutine_scope_deinit(&scope);
+}
+END_TEST
+
+START_TEST(test_coroutine_scope_cancel_ok) {
+    coroutine_scope_t scope;
+    struct worker w[3] = {
+        { .steps = 10, .fail_at = -1 },
+        { .steps = 10, .fail_at = 2 },
+        { .steps = 10, .fail_at = -1 }
+    };
+    struct worker late = { .steps = 10, .fail_at = -1 };
+    size_t i;
+
+    coroutine_scope_init(&scope);
+
+    for (i = 0; i < 3; ++i)
+        coroutine_scope_spawn(&scope, worker_cb, &w[i], STACK_SIZE);
+
+    /* second child fails on the third step and cancels its siblings */
+    coroutine_scope_join(&scope);
+
+    ck_assert_int_eq(coroutine_scope_cancelled(&scope), true);
+    ck_assert_int_eq(w[1].done, 2);
+    ck_assert_int_eq(w[1].cancelled, false);
+
+    /* both siblings get cancellation on resuming from their yield,
+     * third one is not through its third step yet */
+    ck_assert_int_eq(w[0].cancelled, true);
+    ck_assert_int_eq(w[0].done, 2);
+    ck_assert_int_eq(w[2].cancelled, true);
+    ck_assert_int_eq(w[2].done, 1);
+
+    /* cancelled scope cancels new children */
+    coroutine_scope_spawn(&scope, worker_cb, &late, STACK_SIZE);
+    coroutine_scope_join(&scope);
+    ck_assert_int_eq(late.cancelled, true);
+    ck_assert_int_eq(late.done, 0);
+
+    coroutine_scope_deinit(&scope);
+}
+END_TEST
+
+START_TEST(test_coroutine_scope_deinit_ok) {
+    coroutine_scope_t scope;
+    struct worker w = { .steps = 10, .fail_at = -1 };
+
+    coroutine_scope_init(&scope);
+    coroutine_scope_spawn(&scope, worker_cb, &w, STACK_SIZE);
+
+    /* deadline passed, outstanding child is cancelled */
+    ck_assert_int_eq(coroutine_scope_step(&scope), 1);
+    coroutine_scope_deinit(&scope);
+
+    ck_assert_int_eq(w.cancelled, true);
+    ck_assert_int_eq(w.done, 0);
+}
+END_TEST
+
+START_TEST(test_coroutine_stack_pool_ok) {
+    coroutine_stack_pool_t pool;
+    coroutine_stack_t st[3];
+    void *map;
+
+    coroutine_stack_pool_init(&pool, 2);
+
+    coroutine_stack_alloc(&pool, &st[0], STACK_SIZE - 1);
+    ck_assert_ptr_ne(st[0].map, NULL);
+    ck_assert_int_eq(st[0].size, STACK_SIZE);
+    ck_assert_int_gt(st[0].map_size, st[0].size);
+    ck_assert_ptr_eq((char *)st[0].data + st[0].size,
+                     (char *)st[0].map + st[0].map_size);
+
+    map = st[0].map;
+
+    coroutine_stack_release(&pool, &st[0]);
+    ck_assert_int_eq(pool.cached_count, 1);
+    ck_assert_ptr_eq(st[0].map, NULL);
+
+    /* different size is not taken from cache */
+    coroutine_stack_alloc(&pool, &st[1], 2 * STACK_SIZE);
+    ck_assert_ptr_ne(st[1].map, map);
+    ck_assert_int_eq(pool.cached_count, 1);
+
+    coroutine_stack_alloc(&pool, &st[0], STACK_SIZE);
+    ck_assert_ptr_eq(st[0].map, map);
+    ck_assert_int_eq(pool.cached_count, 0);
+
+    coroutine_stack_alloc(&pool, &st[2], STACK_SIZE);
+
+    coroutine_stack_release(&pool, &st[0]);
+    coroutine_stack_release(&pool, &st[1]);
+    coroutine_stack_release(&pool, &st[2]);
+    ck_assert_int_eq(pool.cached_count, 2);
+
+    coroutine_stack_pool_deinit(&pool);
+    ck_assert_int_eq(pool.cached_count, 0);
+}
+END_TEST
+
+START_TEST(test_coroutine_init_pooled_ok) {
+    coroutine_stack_pool_t pool;
+    coroutine_t cr;
+    struct trace t = { .count = 0 };
+    void *map;
+
+    coroutine_stack_pool_init(&pool, 1);
+
+    coroutine_init_pooled(&cr, trace_cb, &t, STACK_SIZE, &pool);
+    map = cr.stack.map;
+
+    while (!coroutine_returned(&cr))
+        coroutine_continue(&cr);
+
+    coroutine_deinit(&cr);
+    ck_assert_int_eq(pool.cached_count, 1);
+
+    coroutine_init_pooled(&cr, trace_cb, &t, STACK_SIZE, &pool);
+    ck_assert_ptr_eq(cr.stack.map, map);
+
+    while (!coroutine_returned(&cr))
+        coroutine_continue(&cr);
+
+    ck_assert_int_eq(t.count, 6);
+
+    coroutine_deinit(&cr);
+    coroutine_stack_pool_deinit(&pool);
+}
+END_TEST
+
+START_TEST(test_generator_ok) {
+    coroutine_t cr;
+    struct range r = { .from = 3, .to = 10 };
+    int *v;
+    int expected = 3;
+
+    coroutine_init(&cr, range_cb, &r, STACK_SIZE);
+
+    while ((v = generator_next(&cr))) {
+        ck_assert_int_eq(*v, expected);
+        ++expected;
+    }
+
+    ck_assert_int_eq(expected, 10);
+    ck_assert_int_eq(generator_done(&cr), true);
+    ck_assert_int_eq(r.cleaned_up, true);
+    ck_assert_ptr_eq(generator_next(&cr), NULL);
+
+    coroutine_deinit(&cr);
+}
+END_TEST
+
+START_TEST(test_generator_stop_ok) {
+    coroutine_t cr;
+    struct range r = { .from = 0, .to = 100 };
+    int *v;
+
+    coroutine_init(&cr, range_cb, &r, STACK_SIZE);
+
+    v = generator_next(&cr);
+    ck_assert_int_eq(*v, 0);
+    v = generator_next(&cr);
+    ck_assert_int_eq(*v, 1);
+
+    generator_stop(&cr);
+
+    ck_assert_int_eq(generator_done(&cr), true);
+    ck_assert_int_eq(r.cleaned_up, true);
+    ck_assert_int_eq(r.last, 1);
+
+    coroutine_deinit(&cr);
+}
+END_TEST
+
+static
+void deep_cb(coroutine_t *cr, void *ctx) {
+    volatile char frame[8 * 1024];
+    size_t i;
+
+    for (i = 0; i < sizeof(frame); ++i)
+        frame[i] = (char)i;
+
+    coroutine_yield(cr);
+}
+
+START_TEST(test_coroutine_pool_ok) {
+    coroutine_pool_t pool;
+    coroutine_t *cr[3];
+    struct trace t = { .count = 0 };
+    coroutine_key_t key;
+    void *map;
+
+    ck_assert_int_eq(coroutine_key_create(&key), true);
+
+    coroutine_pool_init(&pool, STACK_SIZE, 2);
+
+    cr[0] = coroutine_pool_get(&pool, trace_cb, &t);
+    map = cr[0]->stack.map;
+    coroutine_local_set(cr[0], key, &t);
+
+    while (!coroutine_returned(cr[0]))
+        coroutine_continue(cr[0]);
+
+    ck_assert_int_eq(t.count, 3);
+
+    coroutine_pool_put(&pool, cr[0]);
+    ck_assert_int_eq(pool.cached_count, 1);
+
+    /* same coroutine and stack, fresh state */
+    t.count = 0;
+    cr[1] = coroutine_pool_get(&pool, trace_cb, &t);
+    ck_assert_ptr_eq(cr[1], cr[0]);
+    ck_assert_ptr_eq(cr[1]->stack.map, map);
+    ck_assert_int_eq(coroutine_returned(cr[1]), false);
+    ck_assert_ptr_eq(coroutine_local_get(cr[1], key), NULL);
+    ck_assert_int_eq(pool.cached_count, 0);
+
+    /* unfinished coroutine is reused as well */
+    coroutine_continue(cr[1]);
+    ck_assert_int_eq(t.count, 1);
+
+    cr[0] = coroutine_pool_get(&pool, trace_cb, &t);
+    cr[2] = coroutine_pool_get(&pool, trace_cb, &t);
+
+    coroutine_pool_put(&pool, cr[0]);
+    coroutine_pool_put(&pool, cr[1]);
+    coroutine_pool_put(&pool, cr[2]);
+    ck_assert_int_eq(pool.cached_count, 2);
+
+    cr[0] = coroutine_pool_get(&pool, trace_cb, &t);
+    ck_assert_ptr_eq(cr[0], cr[1]);
+
+    t.count = 0;
+
+    while (!coroutine_returned(cr[0]))
+        coroutine_continue(cr[0]);
+
+    ck_assert_int_eq(t.count, 3);
+    ck_assert_int_eq(t.steps[0], 0);
+
+    coroutine_pool_put(&pool, cr[0]);
+
+    coroutine_pool_deinit(&pool);
+}
+END_TEST
+
+START_TEST(test_coroutine_stack_usage_ok) {
+    coroutine_stack_pool_t pool;
+    coroutine_t cr;
+    size_t usage;
+
+    coroutine_stack_pool_init(&pool, 1);
+    coroutine_stack_pool_set_paint(&pool, true);
+
+    coroutine_init_pooled(&cr, deep_cb, NULL, STACK_SIZE, &pool);
+    ck_assert_int_eq(cr.stack.painted, true);
+
+    /* initial frame only */
+    ck_assert_int_lt(coroutine_stack_usage(&cr), 256);
+
+    coroutine_continue(&cr);
+
+    usage = coroutine_stack_usage(&cr);
+    ck_assert_int_ge(usage, 8 * 1024);
+    ck_assert_int_lt(usage, STACK_SIZE / 2);
+
+    coroutine_continue(&cr);
+    ck_assert_int_eq(coroutine_returned(&cr), true);
+    ck_assert_int_eq(coroutine_stack_usage(&cr), usage);
+
+    coroutine_deinit(&cr);
+
+    ck_assert_int_eq(pool.stats.allocated, 1);
+    ck_assert_int_eq(pool.stats.mapped, 1);
+    ck_assert_int_eq(pool.stats.released, 1);
+    ck_assert_int_eq(pool.stats.measured, 1);
+    ck_assert_int_eq(pool.stats.usage_max, usage);
+    ck_assert_int_eq(pool.stats.usage_total, usage);
+
+    /* unpainted stack is measured by resident pages */
+    coroutine_stack_pool_set_paint(&pool, false);
+    coroutine_init_pooled(&cr, deep_cb, NULL, 4 * STACK_SIZE, &pool);
+    ck_assert_int_eq(cr.stack.painted, false);
+
+    coroutine_continue(&cr);
+
+    usage = coroutine_stack_usage(&cr);
+    ck_assert_int_ge(usage, 8 * 1024);
+    ck_assert_int_lt(usage, 4 * STACK_SIZE);
+
+    coroutine_continue(&cr);
+    coroutine_deinit(&cr);
+
+    ck_assert_int_eq(pool.stats.allocated, 2);
+    ck_assert_int_eq(pool.stats.measured, 1);
+
+    coroutine_stack_pool_deinit(&pool);
+}
+END_TEST
+
+struct late_release {
+    pthread_key_t key;
+    coroutine_t cr;
+    struct trace t;
+    bool released;
+};
+
+static
+void late_release_destroy(void *ctx) {
+    struct late_release *lr = ctx;
+
+    /* local stack pool of the thread is already destroyed here */
+    coroutine_deinit(&lr->cr);
+    lr->released = true;
+}
+
+static
+void *late_release_thread(void *ctx) {
+    struct late_release *lr = ctx;
+    int rc;
+
+    coroutine_init(&lr->cr, trace_cb, &lr->t, STACK_SIZE);
+
+    while (!coroutine_returned(&lr->cr))
+        coroutine_continue(&lr->cr);
+
+    rc = pthread_setspecific(lr->key, lr);
+    ck_assert_int_eq(rc, 0);
+
+    return NULL;
+}
+
+START_TEST(test_coroutine_stack_pool_thread_exit_ok) {
+    struct late_release lr = { .t = { .count = 0 }, .released = false };
+    pthread_t th;
+    int rc;
+
+    /* make sure the pool's key is destroyed first */
+    coroutine_stack_pool_local();
+
+    rc = pthread_key_create(&lr.key, late_release_destroy);
+    ck_assert_int_eq(rc, 0);
+
+    rc = pthread_create(&th, NULL, late_release_thread, &lr);
+    ck_assert_int_eq(rc, 0);
+
+    rc = pthread_join(th, NULL);
+    ck_assert_int_eq(rc, 0);
+
+    ck_assert_int_eq(lr.released, true);
+    ck_assert_int_eq(lr.t.count, 3);
+    ck_assert_ptr_eq(lr.cr.stack.map, NULL);
+
+    pthread_key_delete(lr.key);
+}
+END_TEST
+
+Suite *coroutine_suite(void) {
+    Suite *s;
+    TCase *tc;
+
+    s = suite_create("coroutine");
+
+    tc = tcase_create("coroutine");
+
+    tcase_add_test(tc, test_coroutine_continue_yield_ok);
+    tcase_add_test(tc, test_coroutine_fpu_ok);
+    tcase_add_test(tc, test_coroutine_nested_ok);
+    tcase_add_test(tc, test_coroutine_transfer_ok);
+    tcase_add_test(tc, test_coroutine_locals_ok);
+
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("stack");
+
+    tcase_add_test(tc, test_coroutine_stack_pool_ok);
+    tcase_add_test(tc, test_coroutine_init_pooled_ok);
+    tcase_add_test(tc, test_coroutine_stack_pool_thread_exit_ok);
+    tcase_add_test(tc, test_coroutine_pool_ok);
+    tcase_add_test(tc, test_coroutine_stack_usage_ok);
+
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("scope");
+
+    tcase_add_test(tc, test_coroutine_scope_join_ok);
+    tcase_add_test(tc, test_coroutine_scope_cancel_ok);
+    tcase_add_test(tc, test_coroutine_scope_deinit_ok);
+
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("generator");
+
+    tcase_add_test(tc, test_generator_ok);
+    tcase_add_test(tc, test_generator_stop_ok);
+
+    suite_add_tcase(s, tc);
+
+    return s;
+}
@@ -0,0 +1,8 @@
+#ifndef TEST_COROUTINE_H
+# define TEST_COROUTINE_H
+
+# include <check.h>
+
+Suite *coroutine_suite(void);
+
+#endif
@@ -3,6 +3,7 @@
 #include "include/hash-functions.h"
 
 #include <check.h>
+#include <stdlib.h>
 
 START_TEST(test_hash_map_init_ok) {
     hash_map_t hm;
@@ -16,6 +17,62 @@ START_TEST(test_hash_map_init_ok) {
 }
 END_TEST
 
+static
+void *counting_alloc(void *ctx, size_t size) {
+    ++*(size_t *)ctx;
+    return malloc(size);
+}
+
+static
+void *counting_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size) {
+    (void)old_size;
+
+    if (!ptr)
+        ++*(size_t *)ctx;
+
+    return realloc(ptr, new_size);
+}
+
+static
+void counting_free(void *ctx, void *ptr, size_t size) {
+    (void)size;
+    --*(size_t *)ctx;
+    free(ptr);
+}
+
+START_TEST(test_hash_map_allocator_ok) {
+    size_t live = 0;
+    const allocator_t a = {
+        .alloc = counting_alloc,
+        .realloc = counting_realloc,
+        .free = counting_free,
+        .ctx = &live
+    };
+    hash_map_node_data_t hmnd = { NULL, 0 };
+    hash_map_t hm;
+    hash_map_node_t *hmn;
+    int i;
+
+    hash_map_init_allocator(&hm, hash_pearson, hash_update_pearson, &a);
+
+    for (i = 0; i < 10; ++i) {
+        hmn = hash_map_add(&hm, i);
+        hash_map_node_add(hmn, hmnd);
+        hash_map_node_add(hmn, hmnd);
+    }
+
+    /* tree node and two list elements per hash */
+    ck_assert_uint_eq(live, 30);
+
+    for (i = 0; i < 10; ++i)
+        hash_map_remove(&hm, i);
+
+    ck_assert_uint_eq(live, 0);
+
+    hash_map_purge(&hm);
+}
+END_TEST
+
 START_TEST(test_hash_map_add_get_remove_ok) {
     hash_map_t hm;
     hash_map_node_t *hmn[50], *hmn_tst;
@@ -172,6 +229,7 @@ Suite *hash_map_suite(void) {
     tcase_add_test(tc, test_hash_map_init_ok);
     tcase_add_test(tc, test_hash_map_add_get_remove_ok);
     tcase_add_test(tc, test_hash_map_begin_end_next_prev_ok);
+    tcase_add_test(tc, test_hash_map_allocator_ok);
 
     suite_add_tcase(s, tc);
 
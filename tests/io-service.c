@@ -0,0 +1,234 @@
+#include "io-service.h"
+#include "include/io-service.h"
+
+#include <check.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+struct limited {
+    io_service_t iosvc;
+    iosvc_rate_limiter_t rl;
+
+    /* always readable */
+    int fd;
+
+    int count;
+    int stop_at;
+    size_t bytes_per_op;
+
+    /* detach by deinitializing the limiter rather than by resetting it */
+    bool deinit_limiter;
+    bool limiter_alive;
+    bool seen_suspended;
+};
+
+static
+double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static
+void limited_init(struct limited *l,
+                  uint64_t ops_per_sec, uint64_t ops_burst,
+                  uint64_t bytes_per_sec, uint64_t bytes_burst) {
+    static const uint64_t v = 1;
+    ssize_t ret;
+
+    io_service_init(&l->iosvc);
+    io_service_rate_limiter_init(&l->iosvc, &l->rl,
+                                 ops_per_sec, ops_burst,
+                                 bytes_per_sec, bytes_burst);
+
+    l->fd = eventfd(0, EFD_CLOEXEC);
+    ck_assert_int_ge(l->fd, 0);
+
+    ret = write(l->fd, &v, sizeof(v));
+    ck_assert_int_eq(ret, sizeof(v));
+
+    l->count = 0;
+    l->stop_at = 0;
+    l->bytes_per_op = 0;
+    l->deinit_limiter = false;
+    l->limiter_alive = true;
+    l->seen_suspended = false;
+}
+
+static
+void limited_deinit(struct limited *l) {
+    if (l->limiter_alive)
+        io_service_rate_limiter_deinit(&l->rl);
+
+    io_service_deinit(&l->iosvc);
+    close(l->fd);
+}
+
+static
+void limited_cb(int fd, enum io_service_operation op,
+                io_service_t *iosvc, void *ctx) {
+    struct limited *l = ctx;
+
+    ck_assert_int_eq(fd, l->fd);
+    ck_assert_int_eq(op, IO_SVC_OP_READ);
+
+    if (l->bytes_per_op && l->limiter_alive)
+        io_service_rate_limiter_consume(&l->rl, l->bytes_per_op);
+
+    if (++l->count < l->stop_at)
+        return;
+
+    io_service_unwatch_fd(iosvc, fd, IO_SVC_OP_READ);
+    io_service_stop(iosvc, true);
+}
+
+static
+void limited_run(struct limited *l) {
+    io_service_watch_fd(&l->iosvc, l->fd, IO_SVC_OP_READ,
+                        limited_cb, l, false);
+    io_service_set_fd_rate_limiter(&l->iosvc, l->fd, &l->rl);
+
+    /* returns only when both the fd is unwatched and the limiter's
+     * timer is not treated as a pending job */
+    io_service_run(&l->iosvc);
+}
+
+START_TEST(test_rate_limiter_ops_ok) {
+    struct limited l;
+    double start, elapsed;
+
+    /* 5 at once and 10 more at 100 per second */
+    limited_init(&l, 100, 5, 0, 0);
+    l.stop_at = 15;
+
+    start = now();
+    limited_run(&l);
+    elapsed = now() - start;
+
+    ck_assert_int_eq(l.count, 15);
+    ck_assert(elapsed >= 0.095);
+    ck_assert_uint_eq(l.rl.suspended.count, 0);
+
+    limited_deinit(&l);
+}
+END_TEST
+
+START_TEST(test_rate_limiter_bytes_ok) {
+    struct limited l;
+    double start, elapsed;
+
+    /* first op drains the burst, every next one pays off 500 bytes debt */
+    limited_init(&l, 0, 0, 10000, 500);
+    l.stop_at = 5;
+    l.bytes_per_op = 500;
+
+    start = now();
+    limited_run(&l);
+    elapsed = now() - start;
+
+    ck_assert_int_eq(l.count, 5);
+    ck_assert(elapsed >= 0.15);
+
+    limited_deinit(&l);
+}
+END_TEST
+
+static
+void detach_cb(io_service_t *iosvc, void *ctx) {
+    struct limited *l = ctx;
+    avl_tree_node_t *atn_fd;
+    iosvc_fd_desc_t *fd_desc;
+
+    atn_fd = avl_tree_get(&iosvc->fd_map, l->fd);
+    ck_assert_ptr_ne(atn_fd, NULL);
+
+    fd_desc = atn_fd->data;
+
+    if (!fd_desc->suspended) {
+        io_service_enqueue_function(iosvc, detach_cb, l);
+        return;
+    }
+
+    l->seen_suspended = true;
+    ck_assert_uint_eq(l->rl.suspended.count, 1);
+
+    /* re-adding to epoll would fail unless the fd was deleted from there */
+    if (l->deinit_limiter) {
+        io_service_rate_limiter_deinit(&l->rl);
+        l->limiter_alive = false;
+    }
+    else
+        io_service_set_fd_rate_limiter(iosvc, l->fd, NULL);
+
+    ck_assert(!fd_desc->suspended);
+    ck_assert_ptr_eq(fd_desc->limiter, NULL);
+}
+
+static
+void detach_first_cb(int fd, enum io_service_operation op,
+                     io_service_t *iosvc, void *ctx) {
+    struct limited *l = ctx;
+
+    io_service_watch_fd(iosvc, fd, IO_SVC_OP_READ, limited_cb, l, false);
+    io_service_enqueue_function(iosvc, detach_cb, l);
+
+    limited_cb(fd, op, iosvc, ctx);
+}
+
+static
+void test_detach(bool deinit_limiter) {
+    struct limited l;
+    double start, elapsed;
+
+    /* the second op would have to wait for a second */
+    limited_init(&l, 1, 1, 0, 0);
+    l.stop_at = 3;
+    l.deinit_limiter = deinit_limiter;
+
+    io_service_watch_fd(&l.iosvc, l.fd, IO_SVC_OP_READ,
+                        detach_first_cb, &l, false);
+    io_service_set_fd_rate_limiter(&l.iosvc, l.fd, &l.rl);
+
+    start = now();
+    io_service_run(&l.iosvc);
+    elapsed = now() - start;
+
+    ck_assert(l.seen_suspended);
+    ck_assert_int_eq(l.count, 3);
+    ck_assert(elapsed < 0.5);
+
+    limited_deinit(&l);
+}
+
+START_TEST(test_rate_limiter_detach_ok) {
+    test_detach(false);
+}
+END_TEST
+
+START_TEST(test_rate_limiter_deinit_ok) {
+    test_detach(true);
+}
+END_TEST
+
+Suite *io_service_suite(void) {
+    Suite *s;
+    TCase *tc;
+
+    s = suite_create("io service");
+
+    tc = tcase_create("rate limiter");
+
+    tcase_add_test(tc, test_rate_limiter_ops_ok);
+    tcase_add_test(tc, test_rate_limiter_bytes_ok);
+    tcase_add_test(tc, test_rate_limiter_detach_ok);
+    tcase_add_test(tc, test_rate_limiter_deinit_ok);
+
+    suite_add_tcase(s, tc);
+
+    return s;
+}
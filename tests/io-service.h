@@ -0,0 +1,8 @@
+#ifndef TEST_IO_SERVICE_H
+# define TEST_IO_SERVICE_H
+
+# include <check.h>
+
+Suite *io_service_suite(void);
+
+#endif
@@ -2,6 +2,12 @@
 #include "avl-tree.h"
 #include "hash-map.h"
 #include "set.h"
+#include "typed-containers.h"
+#include "coroutine.h"
+#include "coroutine-scheduler.h"
+#include "coroutine-channel.h"
+#include "coroutine-sync.h"
+#include "io-service.h"
 
 #include <check.h>
 #include <stdlib.h>
@@ -24,6 +30,24 @@ int main(/*int argc, char *argv[]*/) {
     s = set_suite();
     srunner_add_suite(runner, s);
 
+    s = typed_containers_suite();
+    srunner_add_suite(runner, s);
+
+    s = coroutine_suite();
+    srunner_add_suite(runner, s);
+
+    s = coroutine_scheduler_suite();
+    srunner_add_suite(runner, s);
+
+    s = coroutine_channel_suite();
+    srunner_add_suite(runner, s);
+
+    s = coroutine_sync_suite();
+    srunner_add_suite(runner, s);
+
+    s = io_service_suite();
+    srunner_add_suite(runner, s);
+
     srunner_run_all(runner, CK_NORMAL);
     nfailed = srunner_ntests_failed(runner);
 
@@ -0,0 +1,207 @@
+#include "typed-containers.h"
+#include "include/typed-containers.h"
+#include "include/arena.h"
+
+#include <check.h>
+#include <string.h>
+
+DECLARE_VECTOR(ivec, int)
+
+struct point {
+    double x, y;
+};
+
+DECLARE_VECTOR(pvec, struct point)
+
+DECLARE_AVL(imap, int, double, TYPED_CMP_SCALAR)
+
+DECLARE_AVL(smap, const char *, int, strcmp)
+
+/* verify order, heights, balance and parent links, return height */
+static
+int check_imap_node(imap_node_t *n) {
+    int l, r;
+
+    if (!n)
+        return 0;
+
+    if (n->left) {
+        ck_assert_ptr_eq(n->left->parent, n);
+        ck_assert_int_lt(n->left->key, n->key);
+    }
+
+    if (n->right) {
+        ck_assert_ptr_eq(n->right->parent, n);
+        ck_assert_int_gt(n->right->key, n->key);
+    }
+
+    l = check_imap_node(n->left);
+    r = check_imap_node(n->right);
+
+    ck_assert_int_le(l - r, 1);
+    ck_assert_int_ge(l - r, -1);
+    ck_assert_int_eq(n->height, (l > r ? l : r) + 1);
+
+    return n->height;
+}
+
+START_TEST(test_typed_vector_ok) {
+    static const int src[] = { 100, 101, 102 };
+    ivec_t v;
+    pvec_t p;
+    int i, last;
+
+    ivec_init(&v);
+    ck_assert_uint_eq(ivec_size(&v), 0);
+    ck_assert_int_eq(ivec_pop_back(&v, &last), false);
+
+    for (i = 0; i < 100; ++i)
+        ivec_push_back(&v, i);
+
+    ck_assert_uint_eq(ivec_size(&v), 100);
+    ck_assert_uint_ge(ivec_capacity(&v), 100);
+
+    for (i = 0; i < 100; ++i)
+        ck_assert_int_eq(*ivec_get(&v, i), i);
+
+    ck_assert_int_eq(ivec_end(&v) - ivec_begin(&v), 100);
+
+    *ivec_insert(&v, 0) = -1;
+    ck_assert_int_eq(*ivec_get(&v, 0), -1);
+    ck_assert_int_eq(*ivec_get(&v, 1), 0);
+
+    ivec_remove(&v, 0);
+    ck_assert_int_eq(*ivec_get(&v, 0), 0);
+
+    ivec_append_n(&v, src, 3);
+    ck_assert_uint_eq(ivec_size(&v), 103);
+    ck_assert_int_eq(*ivec_get(&v, 102), 102);
+
+    ck_assert_int_eq(ivec_pop_back(&v, &last), true);
+    ck_assert_int_eq(last, 102);
+
+    ivec_clear(&v);
+    ck_assert_uint_eq(ivec_size(&v), 0);
+
+    ivec_deinit(&v);
+
+    pvec_init(&p);
+    pvec_reserve(&p, 4);
+    ck_assert_uint_eq(pvec_capacity(&p), 4);
+
+    pvec_append(&p)->x = 1.5;
+    ck_assert(pvec_get(&p, 0)->x == 1.5);
+
+    pvec_deinit(&p);
+}
+END_TEST
+
+START_TEST(test_typed_avl_ok) {
+    imap_t m;
+    imap_node_t *n;
+    bool present[512] = { false };
+    bool inserted;
+    double *val;
+    int i, k, prev;
+    unsigned int seed = 1;
+
+    imap_init(&m);
+    ck_assert_ptr_eq(imap_first(&m), NULL);
+    ck_assert_ptr_eq(imap_get(&m, 0), NULL);
+
+    for (i = 0; i < 4096; ++i) {
+        seed = seed * 1103515245 + 12345;
+        k = (seed >> 16) % 512;
+
+        if ((seed >> 8) % 3) {
+            val = imap_insert(&m, k, &inserted);
+            ck_assert_int_eq(inserted, !present[k]);
+            *val = k / 2.;
+            present[k] = true;
+        }
+        else {
+            ck_assert_int_eq(imap_remove(&m, k), present[k]);
+            present[k] = false;
+        }
+
+        if (!(i % 256))
+            check_imap_node(m.root);
+    }
+
+    check_imap_node(m.root);
+
+    for (k = 0, i = 0; k < 512; ++k) {
+        val = imap_get(&m, k);
+        ck_assert_int_eq(!!val, present[k]);
+
+        if (val) {
+            ck_assert(*val == k / 2.);
+            ++i;
+        }
+    }
+
+    ck_assert_uint_eq(imap_size(&m), i);
+
+    /* in order both ways */
+    for (prev = -1, n = imap_first(&m); n; n = imap_next(n)) {
+        ck_assert_int_gt(n->key, prev);
+        prev = n->key;
+    }
+
+    ck_assert_int_eq(prev, imap_last(&m)->key);
+
+    for (prev = 512, n = imap_last(&m); n; n = imap_prev(n)) {
+        ck_assert_int_lt(n->key, prev);
+        prev = n->key;
+    }
+
+    imap_purge(&m);
+    ck_assert_uint_eq(imap_size(&m), 0);
+    ck_assert_ptr_eq(m.root, NULL);
+}
+END_TEST
+
+START_TEST(test_typed_avl_strings_arena_ok) {
+    static const char *words[] = {
+        "delta", "alpha", "echo", "charlie", "bravo"
+    };
+    smap_t m;
+    arena_t a;
+    size_t idx;
+
+    arena_init(&a, 0);
+    smap_init_allocator(&m, arena_allocator(&a));
+
+    for (idx = 0; idx < 5; ++idx)
+        *smap_insert(&m, words[idx], NULL) = (int)idx;
+
+    ck_assert_int_eq(*smap_get(&m, "charlie"), 3);
+    ck_assert_ptr_eq(smap_get(&m, "foxtrot"), NULL);
+    ck_assert_str_eq(smap_first(&m)->key, "alpha");
+    ck_assert_str_eq(smap_next(smap_first(&m))->key, "bravo");
+    ck_assert_str_eq(smap_last(&m)->key, "echo");
+
+    ck_assert_int_eq(smap_remove(&m, "alpha"), true);
+    ck_assert_str_eq(smap_first(&m)->key, "bravo");
+
+    smap_purge(&m);
+    arena_deinit(&a);
+}
+END_TEST
+
+Suite *typed_containers_suite(void) {
+    Suite *s;
+    TCase *tc;
+
+    s = suite_create("typed containers");
+
+    tc = tcase_create("typed containers");
+
+    tcase_add_test(tc, test_typed_vector_ok);
+    tcase_add_test(tc, test_typed_avl_ok);
+    tcase_add_test(tc, test_typed_avl_strings_arena_ok);
+
+    suite_add_tcase(s, tc);
+
+    return s;
+}
@@ -0,0 +1,8 @@
+#ifndef TEST_TYPED_CONTAINERS_H
+# define TEST_TYPED_CONTAINERS_H
+
+# include <check.h>
+
+Suite *typed_containers_suite(void);
+
+#endif